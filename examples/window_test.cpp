@@ -44,7 +44,7 @@ int main() {
 		}
 	});
 	event_manager.add_listener([](event::CharacterInput const& event) {
-		fmt::print("The character '{}' was input. Repeat: {}\n", event.character, event.is_repeated);
+		fmt::print("The character '{}' was input. Repeat: {}\n", event.character(), event.is_repeated);
 	});
 	event_manager.add_listener([](event::MouseDown const& event) {
 		fmt::print("The mouse button '{}' was {}.\n", enum_name(event.button), event.is_double_click ? "double clicked" : "pressed");
@@ -8,6 +8,8 @@
 #include "avo/math.hpp"
 #include "avo/miscellaneous.hpp"
 #include "avo/node.hpp"
+#include "avo/node_arena.hpp"
+#include "avo/tracing.hpp"
 #include "avo/unicode.hpp"
 #include "avo/util.hpp"
 #include "avo/window.hpp"
@@ -0,0 +1,375 @@
+#ifndef AVO_CONCURRENCY_BROADCAST_CHANNEL_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_BROADCAST_CHANNEL_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "miscellaneous.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace avo::concurrency {
+
+/*
+	The ring buffer shared by the sender and the receivers of a broadcast channel.
+
+	There is a single producer, which never waits for the receivers. Every receiver has its own cursor into the ring,
+	so each message is written once and read by every receiver without being copied into separate queues.
+	When a receiver falls more than the capacity behind, the producer overwrites messages it has not read yet;
+	the receiver then skips to the oldest message that is still in the ring and counts the ones it missed.
+	This way a slow receiver can be detected, but it never holds up the producer or the other receivers.
+
+	Each slot is a seqlock: its sequence number is odd while the producer writes the message and even when the message
+	is complete. A receiver reads the sequence number before and after copying the message, and the copy is only valid
+	if the message was neither being written nor replaced in between. The message is stored as relaxed atomic words so
+	that such a torn read is not a data race; this is why T has to be trivially copyable.
+
+	See create_broadcast_channel, BroadcastSender, BroadcastReceiver.
+*/
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+class BroadcastQueue final {
+public:
+	/*
+		Writes a message to the slot at a position without making it visible to the receivers.
+		Must only be called from the producer thread, for positions at or after the published position.
+	*/
+	void write(std::size_t const position, T const& message) {
+		auto& slot = slots_[position & mask_];
+
+		slot.sequence.store(position*2 + 1, std::memory_order::relaxed);
+		// Orders the odd sequence number before the new words, for receivers that read them.
+		std::atomic_thread_fence(std::memory_order::release);
+
+		auto words = std::array<Word_, word_count_>{};
+		std::memcpy(words.data(), &message, sizeof(T));
+		for (auto const index : std::views::iota(std::size_t{}, word_count_)) {
+			slot.words[index].store(words[index], std::memory_order::relaxed);
+		}
+
+		slot.sequence.store(position*2 + 2, std::memory_order::release);
+	}
+	/*
+		Makes the messages before a position visible to the receivers and wakes the ones that wait.
+		Must only be called from the producer thread.
+	*/
+	void publish(std::size_t const end_position) {
+		published_position_.store(end_position, std::memory_order::release);
+		published_position_.notify_all();
+	}
+
+	/*
+		Copies the message at a position that has been published.
+		Returns std::nullopt if the message has been overwritten by the producer, or is being overwritten.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_read(std::size_t const position) const {
+		auto const& slot = slots_[position & mask_];
+		auto const expected_sequence = position*2 + 2;
+
+		if (slot.sequence.load(std::memory_order::acquire) != expected_sequence) {
+			return std::nullopt;
+		}
+
+		auto words = std::array<Word_, word_count_>{};
+		for (auto const index : std::views::iota(std::size_t{}, word_count_)) {
+			words[index] = slot.words[index].load(std::memory_order::relaxed);
+		}
+
+		// Orders the reads of the words before the second read of the sequence number.
+		std::atomic_thread_fence(std::memory_order::acquire);
+		if (slot.sequence.load(std::memory_order::relaxed) != expected_sequence) {
+			return std::nullopt;
+		}
+
+		auto bytes = std::array<std::byte, sizeof(T)>{};
+		std::memcpy(bytes.data(), words.data(), sizeof(T));
+		return std::bit_cast<T>(bytes);
+	}
+
+	/*
+		Returns the position after the last published message.
+	*/
+	[[nodiscard]]
+	std::size_t published_position() const {
+		return published_position_.load(std::memory_order::acquire);
+	}
+	/*
+		Waits until the published position is no longer equal to the given one.
+	*/
+	void wait_for_publish(std::size_t const position) const {
+		published_position_.wait(position, std::memory_order::acquire);
+	}
+
+	/*
+		Returns the number of messages that the ring holds.
+		This is the capacity passed to the constructor rounded up to a power of two.
+	*/
+	[[nodiscard]]
+	std::size_t capacity() const {
+		return mask_ + 1;
+	}
+
+	static constexpr auto default_capacity = std::size_t{256};
+
+	/*
+		Throws std::length_error if the capacity cannot be rounded up to a power of two.
+	*/
+	explicit BroadcastQueue(std::size_t const capacity = default_capacity) :
+		mask_{round_up_capacity_(capacity) - 1},
+		slots_{std::make_unique<Slot_[]>(mask_ + 1)}
+	{
+		for (auto const position : std::views::iota(std::size_t{}, mask_ + 1)) {
+			// No position has this sequence number, so receivers never read a slot that has not been written.
+			slots_[position].sequence.store(std::numeric_limits<std::size_t>::max(), std::memory_order::relaxed);
+		}
+	}
+
+	BroadcastQueue(BroadcastQueue&&) = delete;
+	BroadcastQueue& operator=(BroadcastQueue&&) = delete;
+
+	BroadcastQueue(BroadcastQueue const&) = delete;
+	BroadcastQueue& operator=(BroadcastQueue const&) = delete;
+
+private:
+	using Word_ = std::uint64_t;
+	static constexpr auto word_count_ = (sizeof(T) + sizeof(Word_) - 1)/sizeof(Word_);
+
+	struct Slot_ {
+		std::atomic<std::size_t> sequence;
+		std::array<std::atomic<Word_>, word_count_> words;
+	};
+
+	[[nodiscard]]
+	static std::size_t round_up_capacity_(std::size_t const capacity) {
+		if (capacity > std::size_t{1} << (std::numeric_limits<std::size_t>::digits - 2)) {
+			throw std::length_error{"The capacity of a BroadcastQueue is too large to be rounded up to a power of two."};
+		}
+		return std::bit_ceil(std::max(capacity, std::size_t{1}));
+	}
+
+	std::size_t mask_;
+	std::unique_ptr<Slot_[]> slots_;
+
+	alignas(cache_line_size) std::atomic<std::size_t> published_position_{};
+};
+
+//------------------------------
+
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+class BroadcastReceiver;
+
+/*
+	The sending end of a broadcast channel. There is only one, so it can be moved but not copied.
+	Sending never waits and never fails; receivers that fall behind miss the oldest messages instead.
+*/
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+class BroadcastSender final {
+public:
+	/*
+		Sends a message to all receivers.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	void send(Argument_&& ... argument) {
+		queue_->write(end_position_, T(std::forward<Argument_>(argument)...));
+		queue_->publish(++end_position_);
+	}
+	/*
+		Sends the messages from a range to all receivers, making them visible all at once with a single notification.
+		If the range is larger than the capacity, receivers only see the last messages in it.
+		Returns the number of messages that were sent.
+	*/
+	template<std::ranges::input_range Range_>
+		requires std::constructible_from<T, std::ranges::range_reference_t<Range_>>
+	std::size_t send_batch(Range_&& messages) {
+		auto const first = end_position_;
+		for (auto&& message : messages) {
+			queue_->write(end_position_++, T(std::forward<decltype(message)>(message)));
+		}
+		if (end_position_ != first) {
+			queue_->publish(end_position_);
+		}
+		return end_position_ - first;
+	}
+
+	/*
+		Creates a new receiver that receives the messages sent after this call.
+	*/
+	[[nodiscard]]
+	BroadcastReceiver<T> subscribe() const {
+		return BroadcastReceiver<T>{queue_, end_position_};
+	}
+
+	/*
+		Returns the total number of messages that have been sent.
+	*/
+	[[nodiscard]]
+	std::size_t sent_count() const {
+		return end_position_;
+	}
+
+	explicit BroadcastSender(std::shared_ptr<BroadcastQueue<T>> queue) :
+		queue_{std::move(queue)}
+	{}
+
+	BroadcastSender(BroadcastSender&&) = default;
+	BroadcastSender& operator=(BroadcastSender&&) = default;
+
+	BroadcastSender(BroadcastSender const&) = delete;
+	BroadcastSender& operator=(BroadcastSender const&) = delete;
+
+private:
+	std::shared_ptr<BroadcastQueue<T>> queue_;
+	std::size_t end_position_{};
+};
+
+/*
+	A receiving end of a broadcast channel, with its own read position.
+	Every receiver receives every message, unless it falls so far behind that the sender overwrites messages it has not
+	received yet; those are skipped and counted by missed_count.
+	Copying a receiver creates an independent receiver at the same position, which can be used from another thread.
+	A single receiver must only be used from one thread at a time.
+*/
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+class BroadcastReceiver final {
+public:
+	/*
+		Copies the next message if there is one, without waiting.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_receive() {
+		while (true) {
+			if (position_ == cached_end_position_) {
+				cached_end_position_ = queue_->published_position();
+				if (position_ == cached_end_position_) {
+					return std::nullopt;
+				}
+			}
+			if (auto const message = queue_->try_read(position_)) {
+				++position_;
+				return message;
+			}
+			skip_overwritten_();
+		}
+	}
+	/*
+		Waits for the next message and copies it.
+	*/
+	[[nodiscard]]
+	T receive() {
+		while (true) {
+			if (auto const message = try_receive()) {
+				return *message;
+			}
+			queue_->wait_for_publish(position_);
+		}
+	}
+	/*
+		Copies all messages that are currently available to an output iterator, without waiting for new ones.
+		Returns the output iterator after the last received message.
+	*/
+	template<std::output_iterator<T const&> Output_>
+	Output_ receive_all(Output_ output) {
+		while (auto const message = try_receive()) {
+			*output = *message;
+			++output;
+		}
+		return output;
+	}
+
+	/*
+		Returns the number of messages that have been sent but not received yet by this receiver,
+		including ones that it will miss because they have been overwritten.
+	*/
+	[[nodiscard]]
+	std::size_t lag() const {
+		return queue_->published_position() - position_;
+	}
+	/*
+		Returns the number of messages that this receiver skipped because the sender had overwritten them
+		before they were received. A growing count means that the receiver is too slow for the capacity of the channel.
+	*/
+	[[nodiscard]]
+	std::size_t missed_count() const {
+		return missed_count_;
+	}
+
+	BroadcastReceiver(std::shared_ptr<BroadcastQueue<T>> queue, std::size_t const position) :
+		queue_{std::move(queue)},
+		position_{position},
+		cached_end_position_{position}
+	{}
+
+	BroadcastReceiver(BroadcastReceiver const&) = default;
+	BroadcastReceiver& operator=(BroadcastReceiver const&) = default;
+
+	BroadcastReceiver(BroadcastReceiver&&) = default;
+	BroadcastReceiver& operator=(BroadcastReceiver&&) = default;
+
+private:
+	/*
+		Called when the message at the read position has been overwritten.
+		Skips to the oldest published message that the ring can still hold. If the sender is overwriting that one too,
+		this is called again when reading it fails, and the receiver moves on by at least one message each time.
+	*/
+	void skip_overwritten_() {
+		cached_end_position_ = queue_->published_position();
+		auto const oldest_intact = cached_end_position_ - std::min(queue_->capacity(), cached_end_position_);
+		auto const new_position = std::max(oldest_intact, position_ + 1);
+		missed_count_ += new_position - position_;
+		position_ = new_position;
+	}
+
+	std::shared_ptr<BroadcastQueue<T>> queue_;
+	std::size_t position_;
+	std::size_t cached_end_position_;
+	std::size_t missed_count_{};
+};
+
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+struct BroadcastChannel final {
+	BroadcastSender<T> sender;
+	BroadcastReceiver<T> receiver;
+};
+
+/*
+	Creates a single-producer broadcast channel, where every receiver gets every message.
+	More receivers are created by copying a receiver, which starts at the same position as the original,
+	or with BroadcastSender::subscribe, which starts after the messages that have already been sent.
+	This can for example hand the events of a window to a renderer, an accessibility layer and a logger
+	without a separate queue for each of them.
+
+	The capacity is rounded up to a power of two. The sender never waits for the receivers: a receiver that falls
+	more than the capacity behind misses the oldest messages, see BroadcastReceiver::missed_count.
+	The messages need to be trivially copyable since receivers may copy a message while it is being overwritten.
+*/
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+[[nodiscard]]
+BroadcastChannel<T> create_broadcast_channel(std::size_t const capacity = BroadcastQueue<T>::default_capacity) {
+	auto queue = std::make_shared<BroadcastQueue<T>>(capacity);
+	return BroadcastChannel<T>{
+		.sender = BroadcastSender<T>{queue},
+		.receiver = BroadcastReceiver<T>{std::move(queue), 0}
+	};
+}
+
+} // namespace avo::concurrency
+
+#endif
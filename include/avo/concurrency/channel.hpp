@@ -0,0 +1,365 @@
+#ifndef AVO_CONCURRENCY_CHANNEL_HPP_BJORN_SUNDIN_JUNE_2021
+#define AVO_CONCURRENCY_CHANNEL_HPP_BJORN_SUNDIN_JUNE_2021
+
+#include "channel_statistics.hpp"
+#include "event_loop.hpp"
+#include "message_queue.hpp"
+#include "mpmc_message_queue.hpp"
+#include "spsc_message_queue.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace avo::concurrency {
+
+/*
+	Evaluates to whether Queue_ can be used as the message queue of a channel with messages of type T.
+	The queue also tells whether it may be pushed to and taken from by more than one thread,
+	which decides whether the senders and receivers of a channel can be copied.
+	See MessageQueue, SpscMessageQueue, MpmcMessageQueue.
+*/
+template<class Queue_, class T>
+concept IsMessageQueue = std::move_constructible<T> 
+	&& std::constructible_from<Queue_, std::size_t, OverflowPolicy, CoalesceFunction<T>, bool>
+	&& requires(Queue_& queue, Queue_ const& const_queue, T&& message)
+{
+	{ queue.push(std::move(message)) } -> std::same_as<bool>;
+	{ queue.push_wait(std::move(message)) } -> std::same_as<bool>;
+	{ queue.take_next() } -> std::same_as<T>;
+	{ queue.try_take_next() } -> std::same_as<std::optional<T>>;
+	{ queue.take_next_until(std::chrono::steady_clock::now()) } -> std::same_as<std::optional<T>>;
+	queue.remove_next();
+	{ const_queue.recent_size() } -> std::same_as<std::size_t>;
+	{ const_queue.was_recently_empty() } -> std::same_as<bool>;
+	{ const_queue.max_size() } -> std::same_as<std::size_t>;
+	{ const_queue.overflow_policy() } -> std::same_as<OverflowPolicy>;
+	{ const_queue.statistics() } -> std::same_as<std::optional<ChannelStatistics>>;
+	{ Queue_::default_max_size } -> std::convertible_to<std::size_t>;
+	{ Queue_::is_multi_producer } -> std::convertible_to<bool>;
+	{ Queue_::is_multi_consumer } -> std::convertible_to<bool>;
+};
+
+/*
+	Evaluates to whether the consumer of Queue_ can wait for messages without blocking the thread,
+	by registering a MessageWaiter. This is supported by the single-consumer queues.
+*/
+template<class Queue_>
+concept IsAwaitableMessageQueue = requires(Queue_& queue, MessageWaiter& waiter) {
+	{ queue.try_await_message(waiter) } -> std::same_as<bool>;
+};
+
+/*
+	The awaitable returned by Receiver::next.
+	The awaiting coroutine is suspended until a message has been sent, and then resumed on the EventLoop
+	that was running it. It must be running on an EventLoop, so that it is never resumed on the sending thread;
+	otherwise std::logic_error is thrown from the co_await expression.
+	The coroutine must not be destroyed while it is suspended here.
+*/
+template<std::move_constructible T, IsAwaitableMessageQueue Queue_>
+class ReceiveAwaiter final : public MessageWaiter {
+public:
+	[[nodiscard]]
+	bool await_ready() const {
+		return not queue_.was_recently_empty();
+	}
+	[[nodiscard]]
+	bool await_suspend(std::coroutine_handle<> const handle) {
+		handle_ = handle;
+		event_loop_ = EventLoop::current();
+		if (not event_loop_) {
+			throw std::logic_error{"Receiver::next was awaited by a coroutine that is not running on an EventLoop."};
+		}
+		return queue_.try_await_message(*this);
+	}
+	[[nodiscard]]
+	T await_resume() {
+		return queue_.take_next();
+	}
+
+	void wake() override {
+		event_loop_->post(handle_);
+	}
+
+	explicit ReceiveAwaiter(Queue_& queue) :
+		queue_{queue}
+	{}
+
+private:
+	Queue_& queue_;
+	std::coroutine_handle<> handle_;
+	EventLoop* event_loop_{};
+};
+
+/*
+	A sender can be copied only if the queue supports multiple producers,
+	in which case every copy can be used from its own thread.
+	Otherwise it can only be moved. Note that this includes the default MessageQueue, 
+	so senders of channels made by create_channel can no longer be copied; use create_mpmc_channel for that.
+*/
+template<std::move_constructible T, IsMessageQueue<T> Queue_ = MessageQueue<T>>
+class Sender final {
+public:
+	using QueueType = Queue_;
+
+	/*
+		Sends a message through the channel without waiting for it to be received.
+		If the message queue has reached its maximum size, the overflow policy of the channel decides what happens.
+		Returns false if the message was rejected.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool send(Argument_&& ... argument) {
+		return queue_->push(std::forward<Argument_>(argument)...);
+	}
+	/*
+		Sends a message through the channel and waits until it has been received and taken off the queue.
+		If the message queue has reached its maximum size, the overflow policy of the channel decides what happens,
+		except that the message is never coalesced. Returns false if the message was rejected.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool send_wait(Argument_&& ... argument) {
+		return queue_->push_wait(std::forward<Argument_>(argument)...);
+	}
+
+	/*
+		Sends the messages from a range through the channel as if by calling send for each one.
+		This synchronizes with the receiver once for the whole range instead of once per message, where the queue allows it.
+		The elements of the range are copied unless the range yields rvalues, for example through std::move_iterator.
+		Returns the number of messages that were sent, which is less than the size of the range if the queue rejected a message.
+	*/
+	template<std::ranges::input_range Range_>
+		requires std::constructible_from<T, std::ranges::range_reference_t<Range_>>
+	std::size_t send_batch(Range_&& messages) {
+		return queue_->push_range(std::forward<Range_>(messages));
+	}
+
+	/*
+		Returns the number of messages that have been sent but not yet taken off the queue by the receiver.
+	*/
+	std::size_t recent_queue_size() const {
+		return queue_->recent_size();
+	}
+	/*
+		Returns whether any messages have been sent but not yet taken off the queue by the receiver.
+	*/
+	[[nodiscard]]
+	bool was_queue_recently_empty() const {
+		return queue_->was_recently_empty();
+	}
+	/*
+		Returns the statistics of the channel, or std::nullopt if it was not created with statistics enabled.
+		The sender and receiver of a channel share the same statistics.
+	*/
+	[[nodiscard]]
+	std::optional<ChannelStatistics> statistics() const {
+		return queue_->statistics();
+	}
+
+	explicit Sender(std::shared_ptr<Queue_> queue) :
+		queue_{std::move(queue)}
+	{}
+
+	Sender(Sender const&) requires Queue_::is_multi_producer = default;
+	Sender& operator=(Sender const&) requires Queue_::is_multi_producer = default;
+
+	Sender(Sender&&) = default;
+	Sender& operator=(Sender&&) = default;
+
+private:
+	std::shared_ptr<Queue_> queue_;
+};
+
+/*
+	A receiver can be copied only if the queue supports multiple consumers,
+	in which case the copies share the messages between them; each message is received by one of them.
+	Otherwise it can only be moved. Note that this includes the default MessageQueue, 
+	so receivers of channels made by create_channel can no longer be copied; use create_mpmc_channel for that.
+*/
+template<std::move_constructible T, IsMessageQueue<T> Queue_ = MessageQueue<T>>
+class Receiver final {
+public:
+	using QueueType = Queue_;
+
+	/*
+		Waits for the next message and moves it from the queue.
+	*/
+	[[nodiscard]]
+	T receive() {
+		return queue_->take_next();
+	}
+	/*
+		Moves the next message from the queue if there is one, without waiting.
+		Unlike checking was_queue_recently_empty before calling receive, this cannot block if another receiver takes the message in between.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_receive() {
+		return queue_->try_take_next();
+	}
+	/*
+		Waits for the next message for at most the given duration and moves it from the queue.
+		Returns std::nullopt if no message arrived in time.
+	*/
+	template<class Representation_, class Period_>
+	[[nodiscard]]
+	std::optional<T> receive_for(std::chrono::duration<Representation_, Period_> const timeout) {
+		return receive_until(std::chrono::steady_clock::now() + timeout);
+	}
+	/*
+		Waits for the next message until a deadline and moves it from the queue.
+		Returns std::nullopt if no message arrived before the deadline.
+		This can for example be used to wait for input only until the next frame has to be drawn.
+	*/
+	template<class Clock_, class Duration_>
+	[[nodiscard]]
+	std::optional<T> receive_until(std::chrono::time_point<Clock_, Duration_> const deadline) {
+		return queue_->take_next_until(deadline);
+	}
+	/*
+		Returns an awaitable that suspends the awaiting coroutine until the next message has arrived, and then moves it from the queue:
+			auto const message = co_await receiver.next();
+		Unlike receive, this does not block the thread. The coroutine must be running on an EventLoop.
+		Only one coroutine can await the receiver at a time.
+	*/
+	[[nodiscard]]
+	auto next()
+		requires IsAwaitableMessageQueue<Queue_>
+	{
+		return ReceiveAwaiter<T, Queue_>{*queue_};
+	}
+	/*
+		Moves all messages that are currently waiting in the queue to an output iterator, without waiting for new ones.
+		This synchronizes with the sender once for all of the messages instead of once per message.
+		Returns the output iterator after the last received message.
+	*/
+	template<std::output_iterator<T&&> Output_>
+	Output_ receive_all(Output_ output) {
+		return queue_->take_all(std::move(output));
+	}
+	/*
+		Moves all messages that are currently waiting in the queue into a vector, without waiting for new ones.
+		Use receive_all with a reused container to avoid allocating.
+	*/
+	[[nodiscard]]
+	std::vector<T> drain() {
+		auto messages = std::vector<T>{};
+		receive_all(std::back_inserter(messages));
+		return messages;
+	}
+	/*
+		Waits for the next message and returns a copy of it.
+		It is still left in the queue.
+	*/
+	[[nodiscard]]
+	T receive_peek() const
+		requires std::copy_constructible<T> && requires(Queue_ const& queue) { queue.peek_next(); }
+	{
+		return queue_->peek_next();
+	}
+	/*
+		Removes the next message from the queue.
+		Does nothing if there are currently no messages in the queue.
+	*/
+	void remove_next() {
+		queue_->remove_next();
+	}
+
+	/*
+		Returns the number of messages currently waiting in the queue to be received immediately.
+	*/
+	[[nodiscard]]
+	std::size_t recent_queue_size() const {
+		return queue_->recent_size();
+	}
+	/*
+		Returns whether there are any messages waiting in the queue to be received immediately.
+	*/
+	[[nodiscard]]
+	bool was_queue_recently_empty() const {
+		return queue_->was_recently_empty();
+	}
+	/*
+		Returns the statistics of the channel, or std::nullopt if it was not created with statistics enabled.
+		The sender and receiver of a channel share the same statistics.
+	*/
+	[[nodiscard]]
+	std::optional<ChannelStatistics> statistics() const {
+		return queue_->statistics();
+	}
+
+	explicit Receiver(std::shared_ptr<Queue_> queue) :
+		queue_{std::move(queue)}
+	{}
+
+	Receiver(Receiver const&) requires Queue_::is_multi_consumer = default;
+	Receiver& operator=(Receiver const&) requires Queue_::is_multi_consumer = default;
+
+	Receiver(Receiver&&) = default;
+	Receiver& operator=(Receiver&&) = default;
+
+private:
+	std::shared_ptr<Queue_> queue_;
+};
+
+template<std::move_constructible T, IsMessageQueue<T> Queue_ = MessageQueue<T>>
+struct Channel final {
+	Sender<T, Queue_> sender;
+	Receiver<T, Queue_> receiver;
+};
+
+/*
+	Creates a message channel.
+	A message channel consists of a sender and a receiver, and is meant to be used to synchronize/communicate between threads.
+	The sender and receiver privately share a thread-safe message queue which they push and pop messages on.
+	The sender can wait for its message to be received and the receiver can wait for new messages to be sent.
+
+	The queue is an avo::concurrency::MessageQueue<T> by default, which can grow without bounds.
+	Pass avo::concurrency::SpscMessageQueue as Queue_ to use a lock-free ring buffer with a fixed capacity instead.
+	See create_mpmc_channel for a channel with any number of senders and receivers.
+
+	The overflow policy decides what happens when a message is sent while the queue is full; see OverflowPolicy.
+	For example, a channel of input events can merge consecutive mouse movements and grow instead of losing key releases:
+		auto [sender, receiver] = create_channel<Event, SpscMessageQueue>(128, OverflowPolicy::CoalesceOrGrow, &merge_events);
+
+	If collect_statistics is true, the queue records how long messages wait in it, how full it gets and how often
+	messages are rejected or dropped; see ChannelStatistics. This costs a clock reading and a few atomic additions per message.
+*/
+template<std::move_constructible T, template<class> class Queue_ = MessageQueue>
+	requires IsMessageQueue<Queue_<T>, T>
+[[nodiscard]]
+Channel<T, Queue_<T>> create_channel(
+	std::size_t const max_queue_size = Queue_<T>::default_max_size,
+	OverflowPolicy const overflow_policy = OverflowPolicy::Reject,
+	CoalesceFunction<T> const coalesce = nullptr,
+	bool const collect_statistics = false
+) {
+	auto message_queue = std::make_shared<Queue_<T>>(max_queue_size, overflow_policy, coalesce, collect_statistics);
+	return Channel<T, Queue_<T>>{
+		.sender = Sender<T, Queue_<T>>{message_queue},
+		.receiver = Receiver<T, Queue_<T>>{std::move(message_queue)}
+	};
+}
+
+/*
+	Creates a message channel whose sender and receiver can be copied and used from any number of threads.
+	The queue is a lock-free avo::concurrency::MpmcMessageQueue with a fixed capacity, rounded up to a power of two.
+	Messages sent from any of the senders are distributed between the receivers, so that each message is received once.
+	This makes it suitable for handing out work to a group of threads.
+*/
+template<std::move_constructible T>
+[[nodiscard]]
+Channel<T, MpmcMessageQueue<T>> create_mpmc_channel(
+	std::size_t const capacity = MpmcMessageQueue<T>::default_max_size,
+	OverflowPolicy const overflow_policy = OverflowPolicy::Reject,
+	bool const collect_statistics = false
+) {
+	return create_channel<T, MpmcMessageQueue>(capacity, overflow_policy, nullptr, collect_statistics);
+}
+
+} // namespace avo::concurrency
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef AVO_CONCURRENCY_CHANNEL_STATISTICS_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_CHANNEL_STATISTICS_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+
+namespace avo::concurrency {
+
+/*
+	A snapshot of the statistics that a message queue collects when it is created with statistics enabled.
+	See Sender::statistics, Receiver::statistics.
+*/
+struct ChannelStatistics {
+	/*
+		Bucket i of the latency histogram counts messages that spent less than 2^i nanoseconds in the queue
+		(and at least 2^(i - 1) nanoseconds, except for bucket 0). The last bucket also counts everything longer.
+	*/
+	static constexpr auto latency_bucket_count = std::size_t{40};
+
+	std::array<std::uint64_t, latency_bucket_count> latency_histogram;
+
+	// Messages that were added to the queue.
+	std::uint64_t pushed_count;
+	// Messages that were merged into a queued message instead of being added.
+	std::uint64_t coalesced_count;
+	// Messages that were taken off the queue.
+	std::uint64_t taken_count;
+	// Messages that could not be pushed because the queue was full.
+	std::uint64_t rejected_count;
+	// Queued messages that were removed to make room for new ones.
+	std::uint64_t dropped_count;
+	// Times that a consumer which was waiting for a message was woken up.
+	std::uint64_t wake_up_count;
+	// The largest number of messages that have been in the queue at once.
+	std::size_t high_water_mark;
+
+	/*
+		Returns the exclusive upper bound of the latencies counted in a bucket of the latency histogram.
+	*/
+	[[nodiscard]]
+	static constexpr std::chrono::nanoseconds latency_bucket_limit(std::size_t const bucket) {
+		return std::chrono::nanoseconds{std::int64_t{1} << bucket};
+	}
+
+	/*
+		Returns an upper bound for the latency that the given fraction of the taken messages stayed below,
+		for example 0.99 for the 99th percentile. Returns zero if no messages have been taken.
+	*/
+	[[nodiscard]]
+	constexpr std::chrono::nanoseconds latency_percentile(double const fraction) const {
+		auto const total = std::accumulate(latency_histogram.begin(), latency_histogram.end(), std::uint64_t{});
+		if (total == 0) {
+			return {};
+		}
+		auto const target = std::max(static_cast<std::uint64_t>(fraction*static_cast<double>(total)), std::uint64_t{1});
+
+		auto count = std::uint64_t{};
+		for (auto bucket = std::size_t{}; bucket < latency_bucket_count; ++bucket) {
+			count += latency_histogram[bucket];
+			if (count >= target) {
+				return latency_bucket_limit(bucket);
+			}
+		}
+		return latency_bucket_limit(latency_bucket_count - 1);
+	}
+
+	[[nodiscard]]
+	constexpr bool operator==(ChannelStatistics const&) const = default;
+};
+
+namespace detail {
+
+/*
+	Collects the statistics of a message queue.
+	Every counter is a relaxed atomic, so recording costs a few uncontended atomic additions
+	and the producer and consumer never wait for each other here.
+*/
+class ChannelStatisticsRecorder final {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/*
+		Called by the producer after a message has been added, with the number of messages in the queue including it.
+	*/
+	void record_push(std::size_t const size) {
+		pushed_count_.fetch_add(1, std::memory_order::relaxed);
+
+		auto high_water_mark = high_water_mark_.load(std::memory_order::relaxed);
+		while (size > high_water_mark && not high_water_mark_.compare_exchange_weak(high_water_mark, size, std::memory_order::relaxed)) {}
+	}
+	void record_coalesced() {
+		coalesced_count_.fetch_add(1, std::memory_order::relaxed);
+	}
+	void record_rejected() {
+		rejected_count_.fetch_add(1, std::memory_order::relaxed);
+	}
+	void record_dropped() {
+		dropped_count_.fetch_add(1, std::memory_order::relaxed);
+	}
+	/*
+		Called by the consumer when it has taken a message that was pushed at enqueue_time.
+	*/
+	void record_take(Clock::time_point const enqueue_time, Clock::time_point const now = Clock::now()) {
+		taken_count_.fetch_add(1, std::memory_order::relaxed);
+
+		auto const nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - enqueue_time).count();
+		auto const bucket = std::min(
+			static_cast<std::size_t>(std::bit_width(static_cast<std::uint64_t>(std::max(nanoseconds, std::int64_t{})))),
+			ChannelStatistics::latency_bucket_count - 1
+		);
+		latency_histogram_[bucket].fetch_add(1, std::memory_order::relaxed);
+	}
+	void record_wake_up() {
+		wake_up_count_.fetch_add(1, std::memory_order::relaxed);
+	}
+
+	[[nodiscard]]
+	ChannelStatistics snapshot() const {
+		auto result = ChannelStatistics{
+			.latency_histogram{},
+			.pushed_count = pushed_count_.load(std::memory_order::relaxed),
+			.coalesced_count = coalesced_count_.load(std::memory_order::relaxed),
+			.taken_count = taken_count_.load(std::memory_order::relaxed),
+			.rejected_count = rejected_count_.load(std::memory_order::relaxed),
+			.dropped_count = dropped_count_.load(std::memory_order::relaxed),
+			.wake_up_count = wake_up_count_.load(std::memory_order::relaxed),
+			.high_water_mark = high_water_mark_.load(std::memory_order::relaxed),
+		};
+		std::ranges::transform(latency_histogram_, result.latency_histogram.begin(), [](auto const& count) {
+			return count.load(std::memory_order::relaxed);
+		});
+		return result;
+	}
+
+private:
+	std::array<std::atomic<std::uint64_t>, ChannelStatistics::latency_bucket_count> latency_histogram_{};
+	std::atomic<std::uint64_t> pushed_count_{};
+	std::atomic<std::uint64_t> coalesced_count_{};
+	std::atomic<std::uint64_t> taken_count_{};
+	std::atomic<std::uint64_t> rejected_count_{};
+	std::atomic<std::uint64_t> dropped_count_{};
+	std::atomic<std::uint64_t> wake_up_count_{};
+	std::atomic<std::size_t> high_water_mark_{};
+};
+
+} // namespace detail
+
+} // namespace avo::concurrency
+
+#endif
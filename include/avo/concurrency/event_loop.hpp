@@ -0,0 +1,354 @@
+#ifndef AVO_CONCURRENCY_EVENT_LOOP_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_EVENT_LOOP_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace avo::concurrency {
+
+class EventLoop;
+
+template<class T = void>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+public:
+	[[nodiscard]]
+	std::suspend_always initial_suspend() const noexcept {
+		return {};
+	}
+
+	class FinalAwaiter {
+	public:
+		[[nodiscard]]
+		bool await_ready() const noexcept {
+			return false;
+		}
+		template<std::derived_from<TaskPromiseBase> Promise_>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise_> const handle) noexcept {
+			return handle.promise().finish_(handle);
+		}
+		void await_resume() const noexcept {}
+	};
+	[[nodiscard]]
+	FinalAwaiter final_suspend() const noexcept {
+		return {};
+	}
+
+	void unhandled_exception() noexcept {
+		exception_ = std::current_exception();
+	}
+
+	void set_continuation(std::coroutine_handle<> const continuation) {
+		continuation_ = continuation;
+	}
+	/*
+		Makes the coroutine owned by an event loop, which is told when it finishes.
+	*/
+	void set_event_loop(EventLoop& event_loop) {
+		event_loop_ = &event_loop;
+	}
+
+	void rethrow_if_failed() const {
+		if (exception_) {
+			std::rethrow_exception(exception_);
+		}
+	}
+
+private:
+	/*
+		Resumes the awaiting coroutine, or destroys the finished coroutine if it is owned by an event loop.
+	*/
+	inline std::coroutine_handle<> finish_(std::coroutine_handle<> handle) noexcept;
+
+	std::coroutine_handle<> continuation_;
+	EventLoop* event_loop_{};
+	std::exception_ptr exception_;
+};
+
+template<class T>
+class TaskPromise : public TaskPromiseBase {
+public:
+	[[nodiscard]]
+	Task<T> get_return_object();
+
+	template<std::convertible_to<T> Value_>
+	void return_value(Value_&& value) {
+		result_.emplace(std::forward<Value_>(value));
+	}
+
+	[[nodiscard]]
+	T take_result() {
+		rethrow_if_failed();
+		return std::move(*result_);
+	}
+
+private:
+	std::optional<T> result_;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+	[[nodiscard]]
+	Task<void> get_return_object();
+
+	void return_void() const noexcept {}
+
+	void take_result() const {
+		rethrow_if_failed();
+	}
+};
+
+} // namespace detail
+
+/*
+	A lazily started coroutine that produces a value of type T.
+	The coroutine does not start running until it is awaited with co_await, or until it is spawned on an EventLoop.
+	Awaiting a task resumes the awaiting coroutine when the task has finished, returning its result or
+	rethrowing the exception that escaped it.
+
+	A task owns its coroutine frame, so a suspended coroutine is destroyed together with its Task unless
+	it has been handed over to an EventLoop.
+*/
+template<class T>
+class [[nodiscard]] Task final {
+public:
+	using promise_type = detail::TaskPromise<T>;
+
+	class Awaiter {
+	public:
+		[[nodiscard]]
+		bool await_ready() const noexcept {
+			return handle_.done();
+		}
+		[[nodiscard]]
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> const awaiting) noexcept {
+			handle_.promise().set_continuation(awaiting);
+			return handle_;
+		}
+		T await_resume() {
+			return handle_.promise().take_result();
+		}
+
+		explicit Awaiter(std::coroutine_handle<promise_type> const handle) :
+			handle_{handle}
+		{}
+
+	private:
+		std::coroutine_handle<promise_type> handle_;
+	};
+
+	/*
+		Starts the task and suspends the awaiting coroutine until it has finished.
+	*/
+	[[nodiscard]]
+	Awaiter operator co_await() && noexcept {
+		return Awaiter{handle_};
+	}
+
+	/*
+		Returns whether the coroutine has run to completion.
+	*/
+	[[nodiscard]]
+	bool is_done() const {
+		return handle_.done();
+	}
+
+	/*
+		Gives up ownership of the coroutine.
+	*/
+	[[nodiscard]]
+	std::coroutine_handle<promise_type> release() noexcept {
+		return std::exchange(handle_, nullptr);
+	}
+
+	explicit Task(std::coroutine_handle<promise_type> const handle) :
+		handle_{handle}
+	{}
+	~Task() {
+		if (handle_) {
+			handle_.destroy();
+		}
+	}
+
+	Task(Task&& other) noexcept :
+		handle_{std::exchange(other.handle_, nullptr)}
+	{}
+	Task& operator=(Task&& other) noexcept {
+		std::swap(handle_, other.handle_);
+		return *this;
+	}
+
+	Task(Task const&) = delete;
+	Task& operator=(Task const&) = delete;
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+};
+
+template<class T>
+Task<T> detail::TaskPromise<T>::get_return_object() {
+	return Task<T>{std::coroutine_handle<TaskPromise>::from_promise(*this)};
+}
+inline Task<void> detail::TaskPromise<void>::get_return_object() {
+	return Task<void>{std::coroutine_handle<TaskPromise>::from_promise(*this)};
+}
+
+//------------------------------
+
+/*
+	A single-threaded scheduler for coroutines.
+
+	Spawned tasks and coroutines that are woken up run one at a time on the thread that calls run.
+	Coroutines that wait for something, for example a message with co_await receiver.next(), only occupy
+	their coroutine frame while suspended, so thousands of them can wait at the same time without a stack each.
+
+	Other threads can post coroutines to the loop to have them resumed on the loop thread; this is what
+	the awaitable Receiver does when a message is sent from another thread.
+*/
+class EventLoop final {
+public:
+	/*
+		Hands a task over to the event loop, which starts it the next time the loop runs.
+		The loop destroys the coroutine when it has finished.
+	*/
+	void spawn(Task<> task) {
+		auto const handle = task.release();
+		handle.promise().set_event_loop(*this);
+		++task_count_;
+		post(handle);
+	}
+
+	/*
+		Schedules a suspended coroutine to be resumed on the thread that runs the loop.
+		Can be called from any thread.
+	*/
+	void post(std::coroutine_handle<> const handle) {
+		if (current_ == this) {
+			ready_.push_back(handle);
+			return;
+		}
+		{
+			auto const lock = std::lock_guard{remote_mutex_};
+			remote_ready_.push_back(handle);
+		}
+		remote_post_count_.fetch_add(1, std::memory_order::release);
+		remote_post_count_.notify_one();
+	}
+
+	/*
+		Runs coroutines until all spawned tasks have finished, waiting for coroutines to be posted from other threads when there is nothing to do.
+		If an exception escapes a spawned task, it is rethrown from here after the coroutine that threw it has been destroyed.
+	*/
+	void run() {
+		while (task_count_ > 0) {
+			auto const post_count = remote_post_count_.load(std::memory_order::acquire);
+			if (run_pending() == 0 && task_count_ > 0) {
+				remote_post_count_.wait(post_count, std::memory_order::acquire);
+			}
+		}
+	}
+	/*
+		Runs all coroutines that are ready to be resumed, without waiting for any others.
+		This can be used to integrate the loop into another loop, such as a render loop.
+		Returns the number of coroutines that were resumed.
+		If an exception escapes a spawned task, it is rethrown from here after the coroutine that threw it has been destroyed.
+	*/
+	std::size_t run_pending() {
+		auto const previous = std::exchange(current_, this);
+
+		{
+			auto const lock = std::lock_guard{remote_mutex_};
+			ready_.insert(ready_.end(), remote_ready_.begin(), remote_ready_.end());
+			remote_ready_.clear();
+		}
+
+		auto resume_count = std::size_t{};
+		while (not ready_.empty()) {
+			// Coroutines that are posted while resuming these run in the next round, which keeps the order fair.
+			running_.swap(ready_);
+			for (auto const handle : running_) {
+				handle.resume();
+			}
+			resume_count += running_.size();
+			running_.clear();
+		}
+
+		current_ = previous;
+
+		if (exception_) {
+			std::rethrow_exception(std::exchange(exception_, nullptr));
+		}
+		return resume_count;
+	}
+
+	/*
+		Returns the number of spawned tasks that have not finished yet.
+	*/
+	[[nodiscard]]
+	std::size_t task_count() const {
+		return task_count_;
+	}
+
+	/*
+		Returns the event loop that is running on the calling thread, or nullptr if there is none.
+	*/
+	[[nodiscard]]
+	static EventLoop* current() {
+		return current_;
+	}
+
+	EventLoop() = default;
+
+	EventLoop(EventLoop&&) = delete;
+	EventLoop& operator=(EventLoop&&) = delete;
+
+	EventLoop(EventLoop const&) = delete;
+	EventLoop& operator=(EventLoop const&) = delete;
+
+private:
+	friend class detail::TaskPromiseBase;
+
+	void finish_task_(std::exception_ptr exception) {
+		--task_count_;
+		if (exception and not exception_) {
+			exception_ = std::move(exception);
+		}
+	}
+
+	static inline thread_local EventLoop* current_ = nullptr;
+
+	std::vector<std::coroutine_handle<>> ready_;
+	std::vector<std::coroutine_handle<>> running_;
+	std::size_t task_count_{};
+	std::exception_ptr exception_;
+
+	std::mutex remote_mutex_;
+	std::vector<std::coroutine_handle<>> remote_ready_;
+	std::atomic<std::uint32_t> remote_post_count_{};
+};
+
+std::coroutine_handle<> detail::TaskPromiseBase::finish_(std::coroutine_handle<> const handle) noexcept {
+	if (continuation_) {
+		return continuation_;
+	}
+	if (event_loop_) {
+		event_loop_->finish_task_(std::move(exception_));
+		handle.destroy();
+	}
+	return std::noop_coroutine();
+}
+
+} // namespace avo::concurrency
+
+#endif
@@ -0,0 +1,493 @@
+#ifndef AVO_CONCURRENCY_MESSAGE_QUEUE_HPP_BJORN_SUNDIN_JUNE_2021
+#define AVO_CONCURRENCY_MESSAGE_QUEUE_HPP_BJORN_SUNDIN_JUNE_2021
+
+#include "channel_statistics.hpp"
+#include "miscellaneous.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+namespace avo::concurrency {
+
+/*
+	A thread-safe queue, synchronized with a mutex.
+	It can grow without bounds and is the default queue of a channel.
+	If it is given a maximum size, it supports all of the overflow policies in OverflowPolicy.
+
+	It does not automatically enforce these rules:
+		1. The queue is used by exactly two threads.
+		2. Only one thread pushes messages and only the other thread takes them out.
+		3. The MessageQueue is owned by the thread that lives the longest.
+
+	It is not logical to provide the same interface for both threads.
+	Therefore a channel interface is provided that abstracts a message queue and consists of a sender and a receiver.
+	The message queue is held in a std::shared_ptr to guarantee that no references or pointers are ever left dangling.
+
+	See create_channel, Channel, Sender, Receiver and SpscMessageQueue.
+*/
+template<std::move_constructible T>
+class MessageQueue final {
+public:
+	static constexpr auto is_multi_producer = false;
+	static constexpr auto is_multi_consumer = false;
+
+	/*
+		Adds a message onto the queue.
+		If the queue has reached its maximum size, what happens depends on the overflow policy, see OverflowPolicy.
+		Returns false if the message was rejected, otherwise true.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool push(Argument_&& ... argument) {
+		auto waiter = static_cast<MessageWaiter*>(nullptr);
+		{
+			auto lock = std::unique_lock{mutex_};
+
+			if (is_coalescing(overflow_policy_)) {
+				auto message = T(std::forward<Argument_>(argument)...);
+				if (try_coalesce_(message)) {
+					return true;
+				}
+				make_room_unless_growing_(lock);
+				queue_.push(std::move(message));
+			}
+			else if (make_room_(lock)) {
+				queue_.emplace(std::forward<Argument_>(argument)...);
+			}
+			else {
+				return false;
+			}
+			record_push_();
+			waiter = std::exchange(waiter_, nullptr);
+		}
+
+		notify_next_message_(waiter);
+
+		return true;
+	}
+
+	/*
+		Adds a message onto the queue and waits until it has been removed from the queue by another thread.
+		The message is never coalesced with another one, but otherwise the overflow policy applies like for push.
+		Returns false if the message was rejected, otherwise true.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool push_wait(Argument_&& ... argument) {
+		auto waiter = static_cast<MessageWaiter*>(nullptr);
+		{
+			auto lock = std::unique_lock{mutex_};
+
+			if (not make_room_(lock)) {
+				return false;
+			}
+			
+			queue_.emplace(std::forward<Argument_>(argument)...);
+			record_push_();
+			waiter = std::exchange(waiter_, nullptr);
+		}
+
+		notify_next_message_(waiter);
+
+		// Wait until the queue is empty (this message has been removed by the other thread).
+		has_messages_flag_.wait(true);
+
+		return true;
+	}
+
+	/*
+		Adds messages from a range onto the queue in order, as if by calling push for each one.
+		With the Reject policy, it stops at the first message that does not fit.
+		The queue is locked once and a waiting thread is notified at most once for the whole range,
+		unless it has to wait for the consumer to make room.
+		Returns the number of messages that were pushed or coalesced.
+	*/
+	template<std::ranges::input_range Range_>
+		requires std::constructible_from<T, std::ranges::range_reference_t<Range_>>
+	std::size_t push_range(Range_&& messages) {
+		auto count = std::size_t{};
+		auto waiter = static_cast<MessageWaiter*>(nullptr);
+		{
+			auto lock = std::unique_lock{mutex_};
+
+			for (auto position = std::ranges::begin(messages), end = std::ranges::end(messages); position != end; ++position) {
+				if (is_coalescing(overflow_policy_)) {
+					auto message = T(*position);
+					if (not try_coalesce_(message)) {
+						make_room_unless_growing_(lock);
+						queue_.push(std::move(message));
+						record_push_();
+					}
+				}
+				else if (make_room_(lock)) {
+					queue_.emplace(*position);
+					record_push_();
+				}
+				else {
+					break;
+				}
+				++count;
+			}
+			if (count) {
+				waiter = std::exchange(waiter_, nullptr);
+			}
+		}
+
+		if (count) {
+			notify_next_message_(waiter);
+		}
+
+		return count;
+	}
+
+	/*
+		Moves the next message off the queue, returning it.
+		If the queue is empty, it waits until a new message has been pushed.
+	*/
+	[[nodiscard]]
+	T take_next() {
+		wait_for_next_();
+
+		auto const lock = std::lock_guard{mutex_};
+
+		auto message = std::move(queue_.front());
+		pop_message_(lock);
+
+		return message;
+	}
+	/*
+		Moves the next message off the queue if there is one, without waiting.
+		Checking whether the queue is empty and taking the message happens atomically.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_take_next() {
+		auto const lock = std::lock_guard{mutex_};
+
+		if (queue_.empty()) {
+			return std::nullopt;
+		}
+
+		auto message = std::optional<T>{std::move(queue_.front())};
+		pop_message_(lock);
+
+		return message;
+	}
+	/*
+		Moves the next message off the queue, waiting until a message has been pushed or the deadline has passed.
+		Returns std::nullopt if there was no message before the deadline.
+	*/
+	template<class Clock_, class Duration_>
+	[[nodiscard]]
+	std::optional<T> take_next_until(std::chrono::time_point<Clock_, Duration_> const deadline) {
+		return deadline_waiter_.take_until([this] { return try_take_next(); }, deadline);
+	}
+	/*
+		Returns a copy of the next message in the queue.
+		If the queue is empty, it waits until a new message has been pushed.
+		Returning a reference would not be thread-safe.
+	*/
+	[[nodiscard]]
+	T peek_next() const 
+		requires std::copy_constructible<T>
+	{
+		wait_for_next_();
+		
+		auto const lock = std::lock_guard{mutex_};
+		return queue_.front();
+	}
+
+	/*
+		Moves all messages that are currently in the queue to an output iterator, without waiting.
+		The queue is locked once for all of the messages.
+		Returns the output iterator after the last written message.
+	*/
+	template<std::output_iterator<T&&> Output_>
+	Output_ take_all(Output_ output) {
+		auto const lock = std::lock_guard{mutex_};
+
+		if (queue_.empty()) {
+			return output;
+		}
+		
+		for (; not queue_.empty(); queue_.pop()) {
+			*output = std::move(queue_.front());
+			++output;
+			record_take_();
+		}
+		notify_room_();
+
+		has_messages_flag_.clear();
+		has_messages_flag_.notify_one();
+
+		return output;
+	}
+
+	/*
+		Registers a waiter to be woken by the thread that pushes the next message, if the queue is empty.
+		Returns false without registering the waiter if there already are messages in the queue.
+		Only one waiter can be registered at a time, and it must not be destroyed before it has been woken.
+	*/
+	[[nodiscard]]
+	bool try_await_message(MessageWaiter& waiter) {
+		auto const lock = std::lock_guard{mutex_};
+		if (not queue_.empty()) {
+			return false;
+		}
+		waiter_ = &waiter;
+		return true;
+	}
+
+	/*
+		Removes the next message from the queue.
+		Does nothing if the queue is empty.
+	*/
+	void remove_next() {
+		auto const lock = std::lock_guard{mutex_};
+		if (not queue_.empty()) {
+			pop_message_(lock);
+		}
+	}
+	
+	/*
+		Returns the number of messages currently in the queue.
+	*/
+	[[nodiscard]]
+	std::size_t recent_size() const {
+		auto const lock = std::lock_guard{mutex_};
+		return queue_.size();
+	}
+	/*
+		Returns whether the message queue is currently empty.
+	*/
+	[[nodiscard]]
+	bool was_recently_empty() const {
+		return not has_messages_flag_.test();
+	}
+
+	/*
+		Returns the maximum number of messages in the queue.
+	*/
+	[[nodiscard]]
+	std::size_t max_size() const {
+		return max_size_;
+	}
+	[[nodiscard]]
+	OverflowPolicy overflow_policy() const {
+		return overflow_policy_;
+	}
+
+	/*
+		Returns the statistics collected so far, or std::nullopt if the queue was not created with statistics enabled.
+	*/
+	[[nodiscard]]
+	std::optional<ChannelStatistics> statistics() const {
+		if (statistics_) {
+			return statistics_->snapshot();
+		}
+		return std::nullopt;
+	}
+
+	static constexpr auto default_max_size = static_cast<std::size_t>(-1);
+
+	/*
+		All overflow policies are supported.
+		Throws std::invalid_argument if the policy coalesces messages and coalesce is null, see is_coalescing.
+		If collect_statistics is true, every message is timestamped when it is pushed; see statistics.
+	*/
+	MessageQueue(
+		std::size_t const max_size = default_max_size, 
+		OverflowPolicy const overflow_policy = OverflowPolicy::Reject,
+		CoalesceFunction<T> const coalesce = nullptr,
+		bool const collect_statistics = false
+	) :
+		max_size_{max_size},
+		overflow_policy_{overflow_policy},
+		coalesce_{coalesce},
+		statistics_{collect_statistics ? std::make_unique<detail::ChannelStatisticsRecorder>() : nullptr}
+	{
+		if (is_coalescing(overflow_policy) and not coalesce) {
+			throw std::invalid_argument{"A MessageQueue with a coalescing overflow policy needs a coalesce function."};
+		}
+	} 
+	~MessageQueue() = default;
+
+	MessageQueue(MessageQueue&&) = default;
+	MessageQueue& operator=(MessageQueue&&) = default;
+
+	MessageQueue(MessageQueue const&) = delete;
+	MessageQueue& operator=(MessageQueue const&) = delete;
+		
+private:
+	/*
+		Merges the message into the last message in the queue if there is one and the coalesce function accepts it.
+		mutex_ must be locked.
+	*/
+	[[nodiscard]]
+	bool try_coalesce_(T const& message) {
+		if (queue_.empty() || not coalesce_(queue_.back(), message)) {
+			return false;
+		}
+		if (statistics_) {
+			statistics_->record_coalesced();
+		}
+		return true;
+	}
+	/*
+		Called for a message that was not coalesced. 
+		With OverflowPolicy::CoalesceOrGrow the queue grows past its maximum size instead of waiting.
+	*/
+	void make_room_unless_growing_(std::unique_lock<std::mutex>& lock) {
+		if (overflow_policy_ != OverflowPolicy::CoalesceOrGrow) {
+			make_room_(lock);
+		}
+	}
+	/*
+		Applies the overflow policy until there is room for one more message.
+		Returns false if the message should be rejected.
+	*/
+	bool make_room_(std::unique_lock<std::mutex>& lock) {
+		while (queue_.size() >= max_size_) {
+			switch (overflow_policy_) {
+				case OverflowPolicy::Reject:
+					if (statistics_) {
+						statistics_->record_rejected();
+					}
+					return false;
+				case OverflowPolicy::DropOldest:
+					queue_.pop();
+					if (statistics_) {
+						enqueue_times_.pop();
+						statistics_->record_dropped();
+					}
+					break;
+				case OverflowPolicy::Block:
+				case OverflowPolicy::Coalesce:
+				// Only reached by push_wait, which never coalesces.
+				case OverflowPolicy::CoalesceOrGrow:
+					wait_for_room_(lock);
+					break;
+			}
+		}
+		return true;
+	}
+	void wait_for_room_(std::unique_lock<std::mutex>& lock) {
+		auto const pop_count = pop_count_.load(std::memory_order::relaxed);
+		++blocked_producer_count_;
+
+		// The consumer may not have been told about the messages yet if they were pushed in the same batch.
+		auto const waiter = std::exchange(waiter_, nullptr);
+		lock.unlock();
+		notify_next_message_(waiter);
+
+		pop_count_.wait(pop_count, std::memory_order::relaxed);
+
+		lock.lock();
+		--blocked_producer_count_;
+	}
+	/*
+		Wakes producers that wait for room in the queue. mutex_ must be locked.
+	*/
+	void notify_room_() {
+		if (blocked_producer_count_) {
+			pop_count_.fetch_add(1, std::memory_order::relaxed);
+			pop_count_.notify_all();
+		}
+	}
+
+	/*
+		Timestamps the message that was just added to the back of the queue. mutex_ must be locked.
+	*/
+	void record_push_() {
+		if (statistics_) {
+			enqueue_times_.push(std::chrono::steady_clock::now());
+			statistics_->record_push(queue_.size());
+		}
+	}
+	/*
+		Records the latency of the message at the front of the queue, which is being taken. mutex_ must be locked.
+	*/
+	void record_take_() {
+		if (statistics_) {
+			statistics_->record_take(enqueue_times_.front());
+			enqueue_times_.pop();
+		}
+	}
+
+	void pop_message_(std::lock_guard<std::mutex> const&) {
+		record_take_();
+		queue_.pop();
+		notify_room_();
+
+		// If the queue has been emptied then update the flag.
+		if (queue_.empty()) {
+			has_messages_flag_.clear();
+			has_messages_flag_.notify_one();
+		}
+	}
+
+	/*
+		Assuming a message has been added to the queue, notify any thread that is waiting for new messages using wait_for_next,
+		only if the queue was previously empty. Also wakes a consumer waiting with a deadline and the waiter that was registered 
+		with try_await_message, if any.
+	*/
+	void notify_next_message_(MessageWaiter* const waiter) {
+		if (not has_messages_flag_.test_and_set()) {
+			has_messages_flag_.notify_one();
+		}
+		// The mutex orders this after the check of a consumer that waits with a deadline.
+		auto const is_waiter_notified = deadline_waiter_.notify_if_waiting();
+		if (waiter) {
+			waiter->wake();
+		}
+		if (statistics_ && (is_waiter_notified || waiter)) {
+			statistics_->record_wake_up();
+		}
+	}
+
+	/*
+		Waits until a message has beed pushed onto the queue.
+		Returns immediately if the queue already contains message(s).
+	*/
+	void wait_for_next_() const {
+		if (not has_messages_flag_.test()) {
+			has_messages_flag_.wait(false);
+			if (statistics_) {
+				statistics_->record_wake_up();
+			}
+		}
+	}
+
+	std::size_t max_size_;
+	OverflowPolicy overflow_policy_;
+	CoalesceFunction<T> coalesce_;
+
+	std::queue<T> queue_;
+	mutable std::mutex mutex_;
+
+	// True when the queue is not empty.
+	std::atomic_flag has_messages_flag_{};
+	// Guarded by mutex_.
+	MessageWaiter* waiter_{};
+	std::size_t blocked_producer_count_{};
+	// Incremented when messages are taken while a producer is blocked, which it waits for.
+	std::atomic<std::uint32_t> pop_count_{};
+	detail::DeadlineWaiter deadline_waiter_;
+
+	// Null unless statistics are collected.
+	std::unique_ptr<detail::ChannelStatisticsRecorder> statistics_;
+	// The times that the messages in queue_ were pushed, only used when statistics are collected. Guarded by mutex_.
+	std::queue<std::chrono::steady_clock::time_point> enqueue_times_;
+};
+
+} // namespace avo::concurrency
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef AVO_CONCURRENCY_MISCELLANEOUS_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_MISCELLANEOUS_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <semaphore>
+
+namespace avo::concurrency {
+
+/*
+	The assumed size of a cache line in bytes.
+	Data that is written by different threads is aligned to this size to avoid false sharing.
+
+	std::hardware_destructive_interference_size is not used because its value may differ
+	between compiler flags, which makes it unsuitable for use in headers.
+*/
+inline constexpr auto cache_line_size = std::size_t{64};
+
+//------------------------------
+
+/*
+	What a message queue does when a message is pushed while the queue is full.
+*/
+enum class OverflowPolicy {
+	// The message is not pushed and push returns false.
+	Reject,
+	// push waits until the consumer has taken a message off the queue.
+	Block,
+	// The oldest message in the queue is removed to make room for the new one.
+	DropOldest,
+	/*
+		Whenever a message is pushed while the previously pushed one is still in the queue, 
+		a CoalesceFunction gets the chance to merge the new message into the previous one.
+		If it does not merge them and the queue is full, push waits like with Block.
+	*/
+	Coalesce,
+	/*
+		Merges messages like Coalesce, but push never waits and no message is lost. 
+		If the new message is not merged and the queue is full, the queue grows past its maximum size to hold it. 
+		Only messages that the CoalesceFunction merges are ever combined, so a producer that must stay responsive 
+		never depends on the consumer, while memory only grows with the messages that cannot be merged.
+	*/
+	CoalesceOrGrow,
+};
+
+/*
+	Returns whether messages are merged with a CoalesceFunction under an overflow policy.
+*/
+[[nodiscard]]
+constexpr bool is_coalescing(OverflowPolicy const policy) {
+	return policy == OverflowPolicy::Coalesce || policy == OverflowPolicy::CoalesceOrGrow;
+}
+
+/*
+	Merges an incoming message into the most recently queued one if they are of the same kind, returning true.
+	Returns false and leaves the queued message unchanged if they should be kept as separate messages.
+*/
+template<class T>
+using CoalesceFunction = bool(*)(T& queued, T const& incoming);
+
+//------------------------------
+
+/*
+	Something that waits for a message without blocking a thread, typically a suspended coroutine.
+	Single-consumer message queues can hold one registered waiter, which is woken by the thread that pushes the next message.
+	See Receiver::next, EventLoop.
+*/
+class MessageWaiter {
+public:
+	/*
+		Called from the thread that pushed the message, after the message can be taken.
+	*/
+	virtual void wake() = 0;
+
+protected:
+	~MessageWaiter() = default;
+};
+
+//------------------------------
+
+namespace detail {
+
+/*
+	Lets the consumer of a message queue wait for a message with a deadline, which std::atomic::wait cannot do.
+
+	The consumer announces that it is waiting before it checks the queue a last time, and producers release
+	a semaphore after publishing a message if anyone is waiting. Producers must call notify_if_waiting after
+	a sequentially consistent fence (or with a mutex held that the consumer also locks to check the queue),
+	so that either the consumer sees the message or the producer sees the announcement.
+	A release may arrive after the consumer stopped waiting and wake a later wait spuriously,
+	so the queue is always checked again after waking up.
+*/
+class DeadlineWaiter final {
+public:
+	/*
+		Calls try_take until it returns a message or the deadline has passed.
+		try_take returns a std::optional that is empty if there was no message.
+	*/
+	template<class Function_, class Clock_, class Duration_>
+	[[nodiscard]]
+	auto take_until(Function_ const& try_take, std::chrono::time_point<Clock_, Duration_> const deadline) 
+		-> decltype(try_take())
+	{
+		while (true) {
+			if (auto message = try_take()) {
+				return message;
+			}
+
+			waiting_count_.fetch_add(1, std::memory_order::relaxed);
+			std::atomic_thread_fence(std::memory_order::seq_cst);
+
+			auto message = try_take();
+			auto is_notified = false;
+			if (not message) {
+				is_notified = semaphore_.try_acquire_until(deadline);
+			}
+
+			waiting_count_.fetch_sub(1, std::memory_order::relaxed);
+
+			if (message) {
+				return message;
+			}
+			if (not is_notified) {
+				// The deadline has passed, but a message may have arrived just before it.
+				return try_take();
+			}
+		}
+	}
+
+	/*
+		Called by producers after a message has been published, see the class comment.
+		Returns whether a waiting consumer was notified.
+	*/
+	bool notify_if_waiting() {
+		if (waiting_count_.load(std::memory_order::relaxed) > 0) {
+			semaphore_.release();
+			return true;
+		}
+		return false;
+	}
+
+private:
+	std::atomic<int> waiting_count_{};
+	std::counting_semaphore<> semaphore_{0};
+};
+
+} // namespace detail
+
+} // namespace avo::concurrency
+
+#endif
@@ -0,0 +1,457 @@
+#ifndef AVO_CONCURRENCY_MPMC_MESSAGE_QUEUE_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_MPMC_MESSAGE_QUEUE_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "channel_statistics.hpp"
+#include "miscellaneous.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+
+namespace avo::concurrency {
+
+/*
+	A bounded, lock-free multi-producer multi-consumer queue backed by a ring buffer.
+
+	Every slot in the ring buffer has a sequence number that tells producers and consumers
+	whether the slot is free or holds a message for a given position in the queue.
+	Producers and consumers claim positions by incrementing a shared index with compare-and-swap,
+	so they only contend with each other, not with the other side.
+	This is the bounded queue described by Dmitry Vyukov.
+
+	Threads that wait for a message or for a message to be received block with std::atomic::wait on the sequence
+	number of a slot, so no condition variables or mutexes are involved.
+
+	The Reject, Block and DropOldest overflow policies are supported.
+
+	Any number of threads may push and take messages, so the senders and receivers of
+	a channel with this queue can be copied and handed to other threads.
+	Messages are distributed between the receivers; each message is received exactly once.
+
+	See create_mpmc_channel, MessageQueue, SpscMessageQueue.
+*/
+template<std::move_constructible T>
+class MpmcMessageQueue final {
+public:
+	static constexpr auto is_multi_producer = true;
+	static constexpr auto is_multi_consumer = true;
+
+	/*
+		Adds a message onto the queue.
+		If the queue is full, what happens depends on the overflow policy, see OverflowPolicy.
+		Returns false if the message was rejected, otherwise true.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool push(Argument_&& ... argument) {
+		if (auto const position = claim_free_slot_()) {
+			std::construct_at(slot_storage_(*position), std::forward<Argument_>(argument)...);
+			publish_(*position);
+			return true;
+		}
+		return false;
+	}
+
+	/*
+		Adds a message onto the queue and waits until it has been taken off the queue by any consumer.
+		The overflow policy applies like for push.
+		Returns false if the message was rejected, otherwise true.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool push_wait(Argument_&& ... argument) {
+		auto const position = claim_free_slot_();
+		if (not position) {
+			return false;
+		}
+
+		std::construct_at(slot_storage_(*position), std::forward<Argument_>(argument)...);
+		publish_(*position);
+
+		// The sequence number changes from position + 1 when a consumer has taken the message.
+		auto& sequence = slots_[*position & mask_].sequence;
+		for (auto current = sequence.load(std::memory_order::acquire); current == *position + 1;
+			current = sequence.load(std::memory_order::acquire))
+		{
+			sequence.wait(current, std::memory_order::acquire);
+		}
+
+		return true;
+	}
+
+	/*
+		Adds messages from a range onto the queue in order, as if by calling push for each one.
+		With the Reject policy, it stops at the first message that does not fit.
+		Since other producers may push at the same time, the messages are not necessarily adjacent in the queue.
+		Returns the number of messages that were pushed.
+	*/
+	template<std::ranges::input_range Range_>
+		requires std::constructible_from<T, std::ranges::range_reference_t<Range_>>
+	std::size_t push_range(Range_&& messages) {
+		auto count = std::size_t{};
+		for (auto position = std::ranges::begin(messages), end = std::ranges::end(messages);
+			position != end && push(*position); ++position)
+		{
+			++count;
+		}
+		return count;
+	}
+
+	/*
+		Moves the next message off the queue, returning it.
+		If the queue is empty, it waits until a new message has been pushed.
+	*/
+	[[nodiscard]]
+	T take_next() {
+		while (true) {
+			if (auto const position = try_claim_message_()) {
+				return take_claimed_(*position);
+			}
+			wait_for_message_();
+		}
+	}
+
+	/*
+		Moves the next message off the queue if there is one, without waiting.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_take_next() {
+		if (auto const position = try_claim_message_()) {
+			return take_claimed_(*position);
+		}
+		return std::nullopt;
+	}
+	/*
+		Moves the next message off the queue, waiting until a message has been pushed or the deadline has passed.
+		Returns std::nullopt if there was no message before the deadline.
+	*/
+	template<class Clock_, class Duration_>
+	[[nodiscard]]
+	std::optional<T> take_next_until(std::chrono::time_point<Clock_, Duration_> const deadline) {
+		return deadline_waiter_.take_until([this] { return try_take_next(); }, deadline);
+	}
+
+	/*
+		Moves all messages that are currently in the queue to an output iterator, without waiting.
+		Messages that are pushed while this is running may also be taken.
+		Returns the output iterator after the last written message.
+	*/
+	template<std::output_iterator<T&&> Output_>
+	Output_ take_all(Output_ output) {
+		while (auto const position = try_claim_message_()) {
+			*output = take_claimed_(*position);
+			++output;
+		}
+		return output;
+	}
+
+	/*
+		Removes the next message from the queue.
+		Does nothing if the queue is empty.
+	*/
+	void remove_next() {
+		if (auto const position = try_claim_message_()) {
+			std::destroy_at(slot_(*position));
+			record_take_(*position);
+			release_(*position);
+		}
+	}
+
+	/*
+		Returns the number of messages currently in the queue.
+		Messages that are being pushed or taken by other threads may or may not be counted.
+	*/
+	[[nodiscard]]
+	std::size_t recent_size() const {
+		// The dequeue position is loaded first so that it can never be ahead of the enqueue position.
+		auto const dequeue_position = dequeue_position_.load(std::memory_order::acquire);
+		return enqueue_position_.load(std::memory_order::acquire) - dequeue_position;
+	}
+	/*
+		Returns whether the message queue is currently empty.
+	*/
+	[[nodiscard]]
+	bool was_recently_empty() const {
+		return recent_size() == 0;
+	}
+
+	/*
+		Returns the maximum number of messages in the queue.
+		This is the maximum size passed to the constructor rounded up to a power of two.
+	*/
+	[[nodiscard]]
+	std::size_t max_size() const {
+		return mask_ + 1;
+	}
+
+	[[nodiscard]]
+	OverflowPolicy overflow_policy() const {
+		return overflow_policy_;
+	}
+
+	/*
+		Returns the statistics collected so far, or std::nullopt if the queue was not created with statistics enabled.
+	*/
+	[[nodiscard]]
+	std::optional<ChannelStatistics> statistics() const {
+		if (statistics_) {
+			return statistics_->snapshot();
+		}
+		return std::nullopt;
+	}
+
+	static constexpr auto default_max_size = std::size_t{1024};
+
+	/*
+		Throws std::length_error if max_size cannot be rounded up to a power of two.
+		The coalescing overflow policies are not supported since another producer may be pushing right after the previous message,
+		so std::invalid_argument is thrown for them. The coalesce function is only there to match the other queues.
+		If collect_statistics is true, every message is timestamped when it is pushed; see statistics.
+	*/
+	explicit MpmcMessageQueue(
+		std::size_t const max_size = default_max_size, 
+		OverflowPolicy const overflow_policy = OverflowPolicy::Reject,
+		CoalesceFunction<T> = nullptr,
+		bool const collect_statistics = false
+	) :
+		mask_{round_up_capacity_(max_size) - 1},
+		slots_{std::make_unique<Slot_[]>(mask_ + 1)},
+		overflow_policy_{overflow_policy},
+		statistics_{collect_statistics ? std::make_unique<detail::ChannelStatisticsRecorder>() : nullptr},
+		enqueue_times_{collect_statistics ? std::make_unique<std::chrono::steady_clock::time_point[]>(mask_ + 1) : nullptr}
+	{
+		if (is_coalescing(overflow_policy)) {
+			throw std::invalid_argument{"An MpmcMessageQueue does not support coalescing overflow policies."};
+		}
+		for (auto const position : std::views::iota(std::size_t{}, mask_ + 1)) {
+			slots_[position].sequence.store(position, std::memory_order::relaxed);
+		}
+	}
+	~MpmcMessageQueue() {
+		auto const end = enqueue_position_.load(std::memory_order::acquire);
+		for (auto position = dequeue_position_.load(std::memory_order::acquire); position != end; ++position) {
+			std::destroy_at(slot_(position));
+		}
+	}
+
+	MpmcMessageQueue(MpmcMessageQueue&&) = delete;
+	MpmcMessageQueue& operator=(MpmcMessageQueue&&) = delete;
+
+	MpmcMessageQueue(MpmcMessageQueue const&) = delete;
+	MpmcMessageQueue& operator=(MpmcMessageQueue const&) = delete;
+
+private:
+	/*
+		A slot is free for the position p when its sequence number is p,
+		and holds the message at position p when its sequence number is p + 1.
+	*/
+	struct alignas(cache_line_size) Slot_ {
+		std::atomic<std::size_t> sequence;
+		alignas(T) std::byte storage[sizeof(T)];
+	};
+
+	[[nodiscard]]
+	static std::size_t round_up_capacity_(std::size_t const max_size) {
+		if (max_size > std::size_t{1} << (std::numeric_limits<std::size_t>::digits - 1)) {
+			throw std::length_error{"The maximum size of an MpmcMessageQueue is too large to be rounded up to a power of two."};
+		}
+		// A single slot cannot tell "free for the next lap" apart from "holds a message".
+		return std::bit_ceil(std::max(max_size, std::size_t{2}));
+	}
+
+	[[nodiscard]]
+	T* slot_storage_(std::size_t const position) const {
+		return static_cast<T*>(static_cast<void*>(slots_[position & mask_].storage));
+	}
+	[[nodiscard]]
+	T* slot_(std::size_t const position) const {
+		return std::launder(slot_storage_(position));
+	}
+
+	/*
+		Returns the difference between the sequence number of the slot at a position and an expected sequence number.
+	*/
+	[[nodiscard]]
+	std::ptrdiff_t sequence_difference_(std::size_t const position, std::size_t const expected_sequence) const {
+		return static_cast<std::ptrdiff_t>(
+			slots_[position & mask_].sequence.load(std::memory_order::acquire) - expected_sequence
+		);
+	}
+
+	/*
+		Claims a position to write a message to, if the queue is not full.
+	*/
+	[[nodiscard]]
+	std::optional<std::size_t> try_claim_free_slot_() {
+		auto position = enqueue_position_.load(std::memory_order::relaxed);
+		while (true) {
+			if (auto const difference = sequence_difference_(position, position); difference == 0) {
+				if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order::relaxed)) {
+					return position;
+				}
+			}
+			else if (difference < 0) {
+				// The slot still holds the message from the previous lap.
+				return std::nullopt;
+			}
+			else {
+				// Another producer claimed the position.
+				position = enqueue_position_.load(std::memory_order::relaxed);
+			}
+		}
+	}
+	/*
+		Claims a position to write a message to, applying the overflow policy if the queue is full.
+	*/
+	[[nodiscard]]
+	std::optional<std::size_t> claim_free_slot_() {
+		while (true) {
+			if (auto const position = try_claim_free_slot_()) {
+				return position;
+			}
+			switch (overflow_policy_) {
+				case OverflowPolicy::Reject:
+				case OverflowPolicy::Coalesce:
+				case OverflowPolicy::CoalesceOrGrow:
+					if (statistics_) {
+						statistics_->record_rejected();
+					}
+					return std::nullopt;
+				case OverflowPolicy::DropOldest:
+					// Any thread may take messages, so the producer can remove the oldest one itself.
+					if (auto const oldest = try_claim_message_()) {
+						std::destroy_at(slot_(*oldest));
+						release_(*oldest);
+						if (statistics_) {
+							statistics_->record_dropped();
+						}
+					}
+					break;
+				case OverflowPolicy::Block:
+					wait_for_free_slot_();
+					break;
+			}
+		}
+	}
+	/*
+		Waits until the sequence number of the slot at the next enqueue position changes, if the queue looks full.
+	*/
+	void wait_for_free_slot_() const {
+		auto const position = enqueue_position_.load(std::memory_order::relaxed);
+		auto const& sequence = slots_[position & mask_].sequence;
+
+		auto const current = sequence.load(std::memory_order::acquire);
+		if (static_cast<std::ptrdiff_t>(current - position) < 0) {
+			sequence.wait(current, std::memory_order::acquire);
+		}
+	}
+	void publish_(std::size_t const position) {
+		if (statistics_) {
+			// Released to the consumer together with the message.
+			enqueue_times_[position & mask_] = std::chrono::steady_clock::now();
+		}
+
+		auto& sequence = slots_[position & mask_].sequence;
+		sequence.store(position + 1, std::memory_order::release);
+		sequence.notify_all();
+
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+		auto const is_waiter_notified = deadline_waiter_.notify_if_waiting();
+
+		if (statistics_) {
+			statistics_->record_push(recent_size());
+			if (is_waiter_notified) {
+				statistics_->record_wake_up();
+			}
+		}
+	}
+
+	/*
+		Claims the position of the next message, if the queue is not empty.
+	*/
+	[[nodiscard]]
+	std::optional<std::size_t> try_claim_message_() {
+		auto position = dequeue_position_.load(std::memory_order::relaxed);
+		while (true) {
+			if (auto const difference = sequence_difference_(position, position + 1); difference == 0) {
+				if (dequeue_position_.compare_exchange_weak(position, position + 1, std::memory_order::relaxed)) {
+					return position;
+				}
+			}
+			else if (difference < 0) {
+				// No message has been published at the position yet.
+				return std::nullopt;
+			}
+			else {
+				// Another consumer claimed the position.
+				position = dequeue_position_.load(std::memory_order::relaxed);
+			}
+		}
+	}
+	[[nodiscard]]
+	T take_claimed_(std::size_t const position) {
+		auto const message = slot_(position);
+		auto result = std::move(*message);
+		std::destroy_at(message);
+		record_take_(position);
+		release_(position);
+		return result;
+	}
+	/*
+		Called by a consumer before it releases the slot of a claimed position.
+	*/
+	void record_take_(std::size_t const position) {
+		if (statistics_) {
+			statistics_->record_take(enqueue_times_[position & mask_]);
+		}
+	}
+	/*
+		Makes the slot free for the position one lap ahead.
+	*/
+	void release_(std::size_t const position) {
+		auto& sequence = slots_[position & mask_].sequence;
+		sequence.store(position + mask_ + 1, std::memory_order::release);
+		sequence.notify_all();
+	}
+
+	/*
+		Waits until the sequence number of the slot at the next position changes, if the queue looks empty.
+		The caller has to try to claim a message again afterwards, since another consumer may have taken it.
+	*/
+	void wait_for_message_() const {
+		auto const position = dequeue_position_.load(std::memory_order::relaxed);
+		auto const& sequence = slots_[position & mask_].sequence;
+
+		auto const current = sequence.load(std::memory_order::acquire);
+		if (static_cast<std::ptrdiff_t>(current - (position + 1)) < 0) {
+			sequence.wait(current, std::memory_order::acquire);
+			if (statistics_) {
+				statistics_->record_wake_up();
+			}
+		}
+	}
+
+	std::size_t mask_;
+	std::unique_ptr<Slot_[]> slots_;
+	OverflowPolicy overflow_policy_;
+	// Both are null unless statistics are collected. The timestamps are indexed like the slots.
+	std::unique_ptr<detail::ChannelStatisticsRecorder> statistics_;
+	std::unique_ptr<std::chrono::steady_clock::time_point[]> enqueue_times_;
+
+	alignas(cache_line_size) std::atomic<std::size_t> enqueue_position_{};
+	alignas(cache_line_size) std::atomic<std::size_t> dequeue_position_{};
+
+	alignas(cache_line_size) detail::DeadlineWaiter deadline_waiter_;
+};
+
+} // namespace avo::concurrency
+
+#endif
@@ -0,0 +1,755 @@
+#ifndef AVO_CONCURRENCY_SPSC_MESSAGE_QUEUE_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_SPSC_MESSAGE_QUEUE_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "channel_statistics.hpp"
+#include "miscellaneous.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <thread>
+
+namespace avo::concurrency {
+
+/*
+	A bounded, lock-free single-producer single-consumer queue backed by a ring buffer.
+
+	Pushing and taking a message never locks and never allocates; the storage for all messages
+	is allocated once at construction. The capacity is the maximum size rounded up to a power of two,
+	so that the position of a message in the ring buffer can be found with a bit mask.
+	The indices written by the producer and the consumer live on separate cache lines.
+
+	The same rules as for MessageQueue apply, but they are required for correctness here:
+		1. The queue is used by exactly two threads.
+		2. Only one thread pushes messages and only the other thread takes them out.
+
+	The Reject, Block, Coalesce and CoalesceOrGrow overflow policies are supported.
+	When coalescing, the producer can merge a message into the last one it pushed until the consumer starts taking it.
+	With CoalesceOrGrow, messages that do not fit in the ring buffer are kept in an overflow list protected by a mutex,
+	which the consumer takes from once the ring buffer is empty. The producer keeps adding to the overflow list
+	until the consumer has emptied it, so the messages stay in order.
+
+	Use it as the queue of a channel by passing it to create_channel:
+		auto [sender, receiver] = avo::concurrency::create_channel<int, avo::concurrency::SpscMessageQueue>(256);
+
+	See create_channel, MessageQueue, MpmcMessageQueue.
+*/
+template<std::move_constructible T>
+class SpscMessageQueue final {
+public:
+	static constexpr auto is_multi_producer = false;
+	static constexpr auto is_multi_consumer = false;
+
+	/*
+		Adds a message onto the queue.
+		If the queue is full, what happens depends on the overflow policy, see OverflowPolicy.
+		Returns false if the message was rejected, otherwise true.
+		Must only be called from the producer thread.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool push(Argument_&& ... argument) {
+		auto const tail = tail_.load(std::memory_order::relaxed);
+
+		if (coalesce_) {
+			auto message = T(std::forward<Argument_>(argument)...);
+			if (is_overflowing_ && push_to_overflow_(tail, message, false)) {
+				return true;
+			}
+			if (try_coalesce_(tail, message)) {
+				return true;
+			}
+			if (overflow_policy_ == OverflowPolicy::CoalesceOrGrow && not has_free_slot_(tail) 
+				&& push_to_overflow_(tail, message, true)) 
+			{
+				return true;
+			}
+			make_room_(tail);
+			std::construct_at(slot_storage_(tail), std::move(message));
+		}
+		else if (make_room_(tail)) {
+			std::construct_at(slot_storage_(tail), std::forward<Argument_>(argument)...);
+		}
+		else {
+			return false;
+		}
+		record_push_(tail);
+		publish_(tail + 1);
+
+		return true;
+	}
+
+	/*
+		Adds a message onto the queue and waits until it has been removed from the queue by the consumer.
+		The message is never coalesced with another one, but otherwise the overflow policy applies like for push.
+		Returns false if the message was rejected, otherwise true.
+		Must only be called from the producer thread.
+	*/
+	template<class ... Argument_>
+		requires std::constructible_from<T, Argument_&&...>
+	bool push_wait(Argument_&& ... argument) {
+		auto const tail = tail_.load(std::memory_order::relaxed);
+
+		// The messages in the overflow list were pushed earlier, so they have to be taken first.
+		while (is_overflowing_) {
+			if (auto const count = overflow_count_.load(std::memory_order::acquire)) {
+				overflow_count_.wait(count, std::memory_order::acquire);
+			}
+			else {
+				is_overflowing_ = false;
+			}
+		}
+
+		if (not make_room_(tail)) {
+			return false;
+		}
+
+		std::construct_at(slot_storage_(tail), std::forward<Argument_>(argument)...);
+		record_push_(tail);
+		publish_(tail + 1);
+
+		// The indices only ever increase, and 64 bits do not overflow in practice.
+		for (auto head = head_.load(std::memory_order::acquire); head <= tail;
+			head = head_.load(std::memory_order::acquire))
+		{
+			head_.wait(head, std::memory_order::acquire);
+		}
+
+		return true;
+	}
+
+	/*
+		Adds messages from a range onto the queue in order, as if by calling push for each one.
+		With the Reject policy, it stops at the first message that does not fit.
+		The messages are made visible to the consumer all at once, with at most one notification, 
+		unless the producer has to wait for the consumer to make room.
+		Returns the number of messages that were pushed or coalesced.
+		Must only be called from the producer thread.
+	*/
+	template<std::ranges::input_range Range_>
+		requires std::constructible_from<T, std::ranges::range_reference_t<Range_>>
+	std::size_t push_range(Range_&& messages) {
+		if (coalesce_) {
+			auto count = std::size_t{};
+			for (auto&& message : messages) {
+				push(std::forward<decltype(message)>(message));
+				++count;
+			}
+			return count;
+		}
+
+		auto const first = tail_.load(std::memory_order::relaxed);
+		auto published = first;
+		
+		auto tail = first;
+		for (auto position = std::ranges::begin(messages), end = std::ranges::end(messages); position != end; ++position, ++tail) {
+			if (not has_free_slot_(tail)) {
+				// The consumer has to see the messages before the producer can wait for it to take them.
+				if (tail != published) {
+					publish_(tail);
+					published = tail;
+				}
+				if (not make_room_(tail)) {
+					break;
+				}
+			}
+			std::construct_at(slot_storage_(tail), *position);
+			record_push_(tail);
+		}
+
+		if (tail != published) {
+			publish_(tail);
+		}
+
+		return tail - first;
+	}
+
+	/*
+		Moves the next message off the queue, returning it.
+		If the queue is empty, it waits until a new message has been pushed.
+		Must only be called from the consumer thread.
+	*/
+	[[nodiscard]]
+	T take_next() {
+		auto const head = head_.load(std::memory_order::relaxed);
+		if (auto message = try_take_from_overflow_(head)) {
+			return std::move(*message);
+		}
+		wait_for_message_(head);
+		return take_at_(head);
+	}
+	/*
+		Moves the next message off the queue if there is one, without waiting.
+		Must only be called from the consumer thread.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_take_next() {
+		auto const head = head_.load(std::memory_order::relaxed);
+		if (head == cached_tail_) {
+			cached_tail_ = tail_.load(std::memory_order::acquire);
+			if (head == cached_tail_) {
+				if (auto message = try_take_from_overflow_(head)) {
+					return message;
+				}
+				// The ring buffer may have been filled while the overflow list was checked.
+				if (head == cached_tail_) {
+					return std::nullopt;
+				}
+			}
+		}
+		return take_at_(head);
+	}
+	/*
+		Moves the next message off the queue, waiting until a message has been pushed or the deadline has passed.
+		Returns std::nullopt if there was no message before the deadline.
+		Must only be called from the consumer thread.
+	*/
+	template<class Clock_, class Duration_>
+	[[nodiscard]]
+	std::optional<T> take_next_until(std::chrono::time_point<Clock_, Duration_> const deadline) {
+		return deadline_waiter_.take_until([this] { return try_take_next(); }, deadline);
+	}
+	/*
+		Returns a copy of the next message in the queue.
+		If the queue is empty, it waits until a new message has been pushed.
+		Must only be called from the consumer thread.
+	*/
+	[[nodiscard]]
+	T peek_next() const
+		requires std::copy_constructible<T>
+	{
+		auto const head = head_.load(std::memory_order::relaxed);
+		if (auto const lock = lock_overflow_if_next_(head)) {
+			is_overflow_front_peeked_ = true;
+			return overflow_.front().message;
+		}
+		wait_for_message_(head);
+		close_for_coalescing_(head);
+		return *slot_(head);
+	}
+
+	/*
+		Moves all messages that are currently in the queue to an output iterator, without waiting.
+		The slots of all of the messages are given back to the producer at once.
+		Returns the output iterator after the last written message.
+		Must only be called from the consumer thread.
+	*/
+	template<std::output_iterator<T&&> Output_>
+	Output_ take_all(Output_ output) {
+		auto const first = head_.load(std::memory_order::relaxed);
+		cached_tail_ = tail_.load(std::memory_order::acquire);
+
+		if (first != cached_tail_) {
+			close_for_coalescing_(cached_tail_ - 1);
+
+			for (auto head = first; head != cached_tail_; ++head) {
+				auto const message = slot_(head);
+				*output = std::move(*message);
+				++output;
+				std::destroy_at(message);
+				record_take_(head);
+			}
+
+			release_(cached_tail_);
+		}
+
+		if (auto const lock = lock_overflow_if_next_(cached_tail_)) {
+			for (auto& overflow_message : overflow_) {
+				*output = std::move(overflow_message.message);
+				++output;
+				if (statistics_) {
+					statistics_->record_take(overflow_message.enqueue_time);
+				}
+			}
+			overflow_.clear();
+			is_overflow_front_peeked_ = false;
+			overflow_count_.store(0, std::memory_order::release);
+			overflow_count_.notify_one();
+		}
+
+		return output;
+	}
+
+	/*
+		Registers a waiter to be woken by the producer when it pushes the next message, if the queue is empty.
+		Returns false without registering the waiter if there already are messages in the queue.
+		Only one waiter can be registered at a time, and it must not be destroyed before it has been woken.
+		Must only be called from the consumer thread.
+	*/
+	[[nodiscard]]
+	bool try_await_message(MessageWaiter& waiter) {
+		auto const head = head_.load(std::memory_order::relaxed);
+		if (head != cached_tail_ || overflow_count_.load(std::memory_order::acquire)) {
+			return false;
+		}
+
+		// Released so that the producer sees what the waiter wrote before registering itself when it takes it.
+		waiter_.store(&waiter, std::memory_order::release);
+		// Pairs with the fences in publish_ and push_to_overflow_, 
+		// so that either this sees the new message or the producer sees the waiter.
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+
+		cached_tail_ = tail_.load(std::memory_order::acquire);
+		if (cached_tail_ == head && not overflow_count_.load(std::memory_order::acquire)) {
+			return true;
+		}
+
+		// A message arrived in the meantime. If the producer already took the waiter it will wake it.
+		auto expected = &waiter;
+		return not waiter_.compare_exchange_strong(expected, nullptr, std::memory_order::acq_rel);
+	}
+
+	/*
+		Removes the next message from the queue.
+		Does nothing if the queue is empty.
+		Must only be called from the consumer thread.
+	*/
+	void remove_next() {
+		auto const head = head_.load(std::memory_order::relaxed);
+
+		if (auto const lock = lock_overflow_if_next_(head)) {
+			pop_overflow_();
+			return;
+		}
+		if (head == tail_.load(std::memory_order::acquire)) {
+			return;
+		}
+
+		close_for_coalescing_(head);
+		std::destroy_at(slot_(head));
+		record_take_(head);
+		release_(head + 1);
+	}
+
+	/*
+		Returns the number of messages currently in the queue.
+	*/
+	[[nodiscard]]
+	std::size_t recent_size() const {
+		// The head is loaded first so that it can never be ahead of the tail.
+		auto const head = head_.load(std::memory_order::acquire);
+		return tail_.load(std::memory_order::acquire) - head + overflow_count_.load(std::memory_order::acquire);
+	}
+	/*
+		Returns whether the message queue is currently empty.
+	*/
+	[[nodiscard]]
+	bool was_recently_empty() const {
+		return recent_size() == 0;
+	}
+
+	/*
+		Returns the maximum number of messages in the queue.
+		This is the maximum size passed to the constructor rounded up to a power of two.
+		With OverflowPolicy::CoalesceOrGrow, there can be more messages in the overflow list.
+	*/
+	[[nodiscard]]
+	std::size_t max_size() const {
+		return mask_ + 1;
+	}
+
+	[[nodiscard]]
+	OverflowPolicy overflow_policy() const {
+		return overflow_policy_;
+	}
+
+	/*
+		Returns the statistics collected so far, or std::nullopt if the queue was not created with statistics enabled.
+	*/
+	[[nodiscard]]
+	std::optional<ChannelStatistics> statistics() const {
+		if (statistics_) {
+			return statistics_->snapshot();
+		}
+		return std::nullopt;
+	}
+
+	static constexpr auto default_max_size = std::size_t{1024};
+
+	/*
+		Throws std::length_error if max_size cannot be rounded up to a power of two.
+		OverflowPolicy::DropOldest is not supported since only the consumer can remove messages,
+		so std::invalid_argument is thrown for it. It is also thrown if the policy coalesces messages and coalesce is null.
+		If collect_statistics is true, every message is timestamped when it is pushed; see statistics.
+	*/
+	explicit SpscMessageQueue(
+		std::size_t const max_size = default_max_size,
+		OverflowPolicy const overflow_policy = OverflowPolicy::Reject,
+		CoalesceFunction<T> const coalesce = nullptr,
+		bool const collect_statistics = false
+	) :
+		mask_{round_up_capacity_(max_size) - 1},
+		slots_{std::make_unique<Slot_[]>(mask_ + 1)},
+		overflow_policy_{overflow_policy},
+		coalesce_{is_coalescing(overflow_policy) ? coalesce : nullptr},
+		statistics_{collect_statistics ? std::make_unique<detail::ChannelStatisticsRecorder>() : nullptr},
+		enqueue_times_{collect_statistics ? std::make_unique<std::chrono::steady_clock::time_point[]>(mask_ + 1) : nullptr}
+	{
+		if (overflow_policy == OverflowPolicy::DropOldest) {
+			throw std::invalid_argument{"An SpscMessageQueue does not support the DropOldest overflow policy."};
+		}
+		if (is_coalescing(overflow_policy) and not coalesce) {
+			throw std::invalid_argument{"An SpscMessageQueue with a coalescing overflow policy needs a coalesce function."};
+		}
+	}
+	~SpscMessageQueue() {
+		auto const tail = tail_.load(std::memory_order::acquire);
+		for (auto head = head_.load(std::memory_order::acquire); head != tail; ++head) {
+			std::destroy_at(slot_(head));
+		}
+	}
+
+	SpscMessageQueue(SpscMessageQueue&&) = delete;
+	SpscMessageQueue& operator=(SpscMessageQueue&&) = delete;
+
+	SpscMessageQueue(SpscMessageQueue const&) = delete;
+	SpscMessageQueue& operator=(SpscMessageQueue const&) = delete;
+
+private:
+	struct Slot_ {
+		alignas(T) std::byte storage[sizeof(T)];
+	};
+
+	[[nodiscard]]
+	static std::size_t round_up_capacity_(std::size_t const max_size) {
+		if (max_size > std::size_t{1} << (std::numeric_limits<std::size_t>::digits - 1)) {
+			throw std::length_error{"The maximum size of an SpscMessageQueue is too large to be rounded up to a power of two."};
+		}
+		return std::bit_ceil(std::max(max_size, std::size_t{1}));
+	}
+
+	[[nodiscard]]
+	T* slot_storage_(std::size_t const index) const {
+		return static_cast<T*>(static_cast<void*>(slots_[index & mask_].storage));
+	}
+	[[nodiscard]]
+	T* slot_(std::size_t const index) const {
+		return std::launder(slot_storage_(index));
+	}
+
+	/*
+		Called by the producer.
+		The head index is only reloaded when the cached one says that the queue is full.
+	*/
+	[[nodiscard]]
+	bool has_free_slot_(std::size_t const tail) {
+		if (tail - cached_head_ <= mask_) {
+			return true;
+		}
+		cached_head_ = head_.load(std::memory_order::acquire);
+		return tail - cached_head_ <= mask_;
+	}
+	/*
+		Called by the producer.
+		Applies the overflow policy if the queue is full.
+		Returns false if the message should be rejected.
+	*/
+	bool make_room_(std::size_t const tail) {
+		if (has_free_slot_(tail)) {
+			return true;
+		}
+		if (overflow_policy_ == OverflowPolicy::Reject) {
+			if (statistics_) {
+				statistics_->record_rejected();
+			}
+			return false;
+		}
+		while (tail - cached_head_ > mask_) {
+			head_.wait(cached_head_, std::memory_order::acquire);
+			cached_head_ = head_.load(std::memory_order::acquire);
+		}
+		return true;
+	}
+	/*
+		Called by the producer.
+		Merges the message into the last published one if the consumer has not started taking it yet.
+	*/
+	[[nodiscard]]
+	bool try_coalesce_(std::size_t const tail, T const& message) {
+		auto expected = tail;
+		if (not open_position_.compare_exchange_strong(expected, locked_position_, 
+			std::memory_order::acquire, std::memory_order::relaxed)) 
+		{
+			return false;
+		}
+		auto const is_merged = coalesce_(*slot_(tail - 1), message);
+		open_position_.store(tail, std::memory_order::release);
+
+		if (is_merged && statistics_) {
+			statistics_->record_coalesced();
+		}
+		return is_merged;
+	}
+	/*
+		Called by the producer with OverflowPolicy::CoalesceOrGrow, for a message that was not coalesced into the ring buffer.
+		Adds the message to the overflow list, merging it into the last message there if possible.
+		Returns false without adding the message if the producer can go back to the ring buffer,
+		which is when the consumer has emptied the list, or when is_starting is true and a slot has been released.
+	*/
+	bool push_to_overflow_(std::size_t const tail, T& message, bool const is_starting) {
+		auto const lock = std::scoped_lock{overflow_mutex_};
+
+		if (overflow_.empty()) {
+			if (not is_starting) {
+				is_overflowing_ = false;
+				return false;
+			}
+		}
+		else if (not (overflow_.size() == 1 && is_overflow_front_peeked_) && coalesce_(overflow_.back().message, message)) {
+			if (statistics_) {
+				statistics_->record_coalesced();
+			}
+			return true;
+		}
+
+		overflow_.push_back(OverflowMessage_{
+			.message = std::move(message), 
+			.enqueue_time = statistics_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{},
+		});
+		overflow_count_.store(overflow_.size(), std::memory_order::release);
+
+		if (is_starting) {
+			// Pairs with the fence in lock_overflow_if_next_, so that either the consumer sees the message
+			// or this sees the slots that the consumer released before it looked for messages and started waiting.
+			std::atomic_thread_fence(std::memory_order::seq_cst);
+			if (has_free_slot_(tail)) {
+				message = std::move(overflow_.back().message);
+				overflow_.pop_back();
+				overflow_count_.store(0, std::memory_order::relaxed);
+				return false;
+			}
+			wake_consumer_();
+		}
+		is_overflowing_ = true;
+
+		if (statistics_) {
+			statistics_->record_push(tail - head_.load(std::memory_order::relaxed) + overflow_.size());
+		}
+		return true;
+	}
+	/*
+		Called by the producer after it has constructed a message at the tail index, before publishing it.
+	*/
+	void record_push_(std::size_t const tail) {
+		if (statistics_) {
+			// The consumer reads the timestamp only after the message has been published.
+			enqueue_times_[tail & mask_] = std::chrono::steady_clock::now();
+			statistics_->record_push(tail + 1 - head_.load(std::memory_order::relaxed));
+		}
+	}
+	/*
+		Called by the producer.
+		Makes the messages before the new tail visible to the consumer and wakes it, however it is waiting.
+	*/
+	void publish_(std::size_t const new_tail) {
+		if (coalesce_) {
+			// Opened before the consumer can see the message, so that it knows to close it before taking it.
+			open_position_.store(new_tail, std::memory_order::relaxed);
+		}
+		tail_.store(new_tail, std::memory_order::release);
+		tail_.notify_one();
+
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+		wake_consumer_();
+	}
+	/*
+		Called by the producer after a message has been made visible to the consumer, followed by a sequentially consistent fence.
+		Wakes the consumer if it is waiting with a deadline or a MessageWaiter.
+	*/
+	void wake_consumer_() {
+		if (deadline_waiter_.notify_if_waiting() && statistics_) {
+			statistics_->record_wake_up();
+		}
+		if (waiter_.load(std::memory_order::relaxed)) {
+			if (auto const waiter = waiter_.exchange(nullptr, std::memory_order::acq_rel)) {
+				waiter->wake();
+				if (statistics_) {
+					statistics_->record_wake_up();
+				}
+			}
+		}
+	}
+
+	/*
+		Called by the consumer.
+		Waits until there is a message at the head index.
+		The tail index is only reloaded when the cached one says that the queue is empty.
+	*/
+	void wait_for_message_(std::size_t const head) const {
+		if (head != cached_tail_) {
+			return;
+		}
+		for (cached_tail_ = tail_.load(std::memory_order::acquire); cached_tail_ == head;
+			cached_tail_ = tail_.load(std::memory_order::acquire))
+		{
+			tail_.wait(head, std::memory_order::acquire);
+			if (statistics_) {
+				statistics_->record_wake_up();
+			}
+		}
+	}
+	/*
+		Called by the consumer before it reads the message at a position.
+		Stops the producer from coalescing more messages into it, waiting if the producer is doing that right now.
+	*/
+	void close_for_coalescing_(std::size_t const position) const {
+		if (not coalesce_) {
+			return;
+		}
+		auto expected = position + 1;
+		while (not open_position_.compare_exchange_weak(expected, closed_position_, 
+			std::memory_order::acquire, std::memory_order::relaxed)) 
+		{
+			if (expected == locked_position_) {
+				std::this_thread::yield();
+			}
+			else if (expected != position + 1) {
+				// A later message is open, so this one can no longer be changed by the producer.
+				return;
+			}
+			expected = position + 1;
+		}
+	}
+	/*
+		Called by the consumer.
+		Returns a lock on the overflow list if its first message is the next message in the queue,
+		which is the case when the ring buffer is empty and the list is not. Otherwise returns an empty lock.
+	*/
+	[[nodiscard]]
+	std::unique_lock<std::mutex> lock_overflow_if_next_(std::size_t const head) const {
+		if (overflow_policy_ != OverflowPolicy::CoalesceOrGrow || head != cached_tail_) {
+			return {};
+		}
+		// Pairs with the fence in push_to_overflow_, see the comment there.
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+		if (not overflow_count_.load(std::memory_order::acquire)) {
+			return {};
+		}
+		auto lock = std::unique_lock{overflow_mutex_};
+		// Messages may have been published to the ring buffer before the producer started using the list. 
+		// While the list is not empty, the producer does not publish any more.
+		cached_tail_ = tail_.load(std::memory_order::acquire);
+		if (cached_tail_ != head || overflow_.empty()) {
+			return {};
+		}
+		return lock;
+	}
+	/*
+		Called by the consumer.
+		Moves the first message off the overflow list if it is the next message in the queue.
+	*/
+	[[nodiscard]]
+	std::optional<T> try_take_from_overflow_(std::size_t const head) {
+		if (auto const lock = lock_overflow_if_next_(head)) {
+			auto message = std::optional<T>{std::move(overflow_.front().message)};
+			pop_overflow_();
+			return message;
+		}
+		return std::nullopt;
+	}
+	/*
+		Called by the consumer with the overflow list locked.
+	*/
+	void pop_overflow_() {
+		if (statistics_) {
+			statistics_->record_take(overflow_.front().enqueue_time);
+		}
+		overflow_.pop_front();
+		is_overflow_front_peeked_ = false;
+		overflow_count_.store(overflow_.size(), std::memory_order::release);
+		// A producer in push_wait may be waiting for the list to be emptied.
+		overflow_count_.notify_one();
+	}
+	/*
+		Called by the consumer when there is a message at the head index.
+	*/
+	[[nodiscard]]
+	T take_at_(std::size_t const head) {
+		close_for_coalescing_(head);
+
+		auto const message = slot_(head);
+		auto result = std::move(*message);
+		std::destroy_at(message);
+
+		record_take_(head);
+		release_(head + 1);
+
+		return result;
+	}
+	/*
+		Called by the consumer before it releases the slot at the head index.
+	*/
+	void record_take_(std::size_t const head) {
+		if (statistics_) {
+			statistics_->record_take(enqueue_times_[head & mask_]);
+		}
+	}
+	/*
+		Called by the consumer.
+		Gives the slots before the new head back to the producer.
+	*/
+	void release_(std::size_t const new_head) {
+		head_.store(new_head, std::memory_order::release);
+		head_.notify_one();
+	}
+
+	std::size_t mask_;
+	std::unique_ptr<Slot_[]> slots_;
+	OverflowPolicy overflow_policy_;
+	// Null unless the overflow policy coalesces messages.
+	CoalesceFunction<T> coalesce_;
+	// Both are null unless statistics are collected. The timestamps are indexed like the slots.
+	std::unique_ptr<detail::ChannelStatisticsRecorder> statistics_;
+	std::unique_ptr<std::chrono::steady_clock::time_point[]> enqueue_times_;
+
+	// Written by the consumer.
+	alignas(cache_line_size) std::atomic<std::size_t> head_{};
+	mutable std::size_t cached_tail_{};
+
+	// Written by the producer.
+	alignas(cache_line_size) std::atomic<std::size_t> tail_{};
+	std::size_t cached_head_{};
+
+	/*
+		Only used when the overflow policy coalesces messages.
+		Holds the tail index after the last published message while the producer may still coalesce messages into it,
+		locked_position_ while the producer is doing so, or closed_position_ once the consumer has started taking it.
+	*/
+	static constexpr auto closed_position_ = std::numeric_limits<std::size_t>::max();
+	static constexpr auto locked_position_ = closed_position_ - 1;
+	// Mutable because peeking at a message also closes it.
+	alignas(cache_line_size) mutable std::atomic<std::size_t> open_position_{closed_position_};
+
+	/*
+		Only used with OverflowPolicy::CoalesceOrGrow, for messages that were pushed while the ring buffer was full.
+		The count is the size of the list, and can be read without locking the mutex.
+	*/
+	struct OverflowMessage_ {
+		T message;
+		std::chrono::steady_clock::time_point enqueue_time;
+	};
+	mutable std::mutex overflow_mutex_;
+	std::deque<OverflowMessage_> overflow_;
+	// Like the ring buffer, a message that the consumer has peeked at cannot be changed by the producer.
+	mutable bool is_overflow_front_peeked_{};
+	alignas(cache_line_size) std::atomic<std::size_t> overflow_count_{};
+	// Only used by the producer. True while the producer adds messages to the overflow list instead of the ring buffer.
+	bool is_overflowing_{};
+
+	// Written by the consumer when it starts waiting and by the producer when it wakes it.
+	alignas(cache_line_size) std::atomic<MessageWaiter*> waiter_{};
+	detail::DeadlineWaiter deadline_waiter_;
+};
+
+} // namespace avo::concurrency
+
+#endif
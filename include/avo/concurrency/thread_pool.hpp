@@ -0,0 +1,588 @@
+#ifndef AVO_CONCURRENCY_THREAD_POOL_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_THREAD_POOL_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "work_stealing_deque.hpp"
+#include "../util/int_range.hpp"
+#include "../util/recursive_range.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace avo::concurrency {
+
+namespace detail {
+
+/*
+	A unit of work that has been submitted to a ThreadPool.
+*/
+class PoolTask {
+public:
+	/*
+		Runs the task. This is called exactly once, after which the pool no longer refers to the task.
+	*/
+	virtual void run() noexcept = 0;
+
+	virtual ~PoolTask() = default;
+};
+
+/*
+	The state shared between a task and its Future.
+	It is reference counted by the two of them and deleted by whichever lets go of it last.
+*/
+template<class Result_>
+class FutureState : public PoolTask {
+public:
+	using StoredResult = std::conditional_t<std::is_void_v<Result_>, std::monostate, Result_>;
+
+	[[nodiscard]]
+	bool is_ready() const {
+		return is_ready_.load(std::memory_order::acquire);
+	}
+	void wait() const {
+		is_ready_.wait(false, std::memory_order::acquire);
+	}
+
+	/*
+		Rethrows the exception thrown by the task, if any, or moves the result out.
+		Must only be called when the state is ready.
+	*/
+	[[nodiscard]]
+	Result_ take_result() {
+		if (exception_) {
+			std::rethrow_exception(exception_);
+		}
+		if constexpr (not std::is_void_v<Result_>) {
+			return std::move(*result_);
+		}
+	}
+
+	void release() {
+		if (reference_count_.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+			delete this;
+		}
+	}
+
+protected:
+	template<class Function_>
+	void run_and_release(Function_& function) noexcept {
+		try {
+			if constexpr (std::is_void_v<Result_>) {
+				function();
+				result_.emplace();
+			}
+			else {
+				result_.emplace(function());
+			}
+		}
+		catch (...) {
+			exception_ = std::current_exception();
+		}
+
+		is_ready_.store(true, std::memory_order::release);
+		is_ready_.notify_all();
+		release();
+	}
+
+private:
+	std::atomic<int> reference_count_{2};
+	std::atomic<bool> is_ready_{};
+	std::optional<StoredResult> result_;
+	std::exception_ptr exception_;
+};
+
+template<class Function_, class Result_>
+class FunctionTask final : public FutureState<Result_> {
+public:
+	void run() noexcept override {
+		this->run_and_release(function_);
+	}
+
+	explicit FunctionTask(Function_ function) :
+		function_{std::move(function)}
+	{}
+
+private:
+	Function_ function_;
+};
+
+/*
+	Runs one pending task of the pool that the calling thread is a worker of.
+	Returns false if the calling thread is not a worker of any pool or if there was no task to run.
+*/
+bool try_run_pending_task();
+
+} // namespace detail
+
+/*
+	Refers to the result of a task that has been submitted to a ThreadPool.
+	Unlike std::future it does not allocate any shared state of its own; the result is stored together with the task.
+	It can only be moved, and the result can only be retrieved once.
+*/
+template<class Result_>
+class Future final {
+public:
+	/*
+		Returns whether the task has finished.
+	*/
+	[[nodiscard]]
+	bool is_ready() const {
+		return state_->is_ready();
+	}
+
+	/*
+		Waits until the task has finished.
+		When called from a worker thread of a pool, the thread runs other pending tasks while waiting
+		instead of blocking, so that tasks can wait for the tasks they submit without deadlocking the pool.
+	*/
+	void wait() const {
+		while (not state_->is_ready()) {
+			if (detail::try_run_pending_task()) {
+				continue;
+			}
+			if (is_on_worker_thread_()) {
+				std::this_thread::yield();
+			}
+			else {
+				state_->wait();
+			}
+		}
+	}
+
+	/*
+		Waits until the task has finished and returns its result.
+		If the task threw an exception, it is rethrown here instead.
+		Must only be called once.
+	*/
+	[[nodiscard]]
+	Result_ get() {
+		wait();
+		return state_->take_result();
+	}
+
+	[[nodiscard]]
+	bool is_valid() const {
+		return state_ != nullptr;
+	}
+
+	explicit Future(detail::FutureState<Result_>* const state) :
+		state_{state}
+	{}
+	~Future() {
+		if (state_) {
+			state_->release();
+		}
+	}
+
+	Future(Future&& other) noexcept :
+		state_{std::exchange(other.state_, nullptr)}
+	{}
+	Future& operator=(Future&& other) noexcept {
+		std::swap(state_, other.state_);
+		return *this;
+	}
+
+	Future(Future const&) = delete;
+	Future& operator=(Future const&) = delete;
+
+private:
+	[[nodiscard]]
+	static bool is_on_worker_thread_();
+
+	detail::FutureState<Result_>* state_;
+};
+
+/*
+	A fixed set of worker threads that run submitted tasks, balancing the work between them by stealing.
+
+	Every worker has its own Chase-Lev deque (see WorkStealingDeque). Tasks submitted from a worker, for example
+	by another task, are pushed onto that worker's deque and run in last in, first out order, which keeps
+	related work on the same core. Tasks submitted from other threads go through a shared injection queue.
+	A worker that runs out of tasks takes from the injection queue and then steals from the other workers,
+	oldest tasks first, before it goes to sleep with std::atomic::wait.
+
+	The thread that calls parallel_for runs parts of the loop itself instead of just blocking,
+	which is why the default number of workers leaves one core for the thread that uses the pool.
+	Worker threads that wait for a Future run other pending tasks meanwhile, but other threads simply block.
+
+	The destructor waits until all submitted tasks have run.
+	Submitting tasks while the pool is being destroyed is not allowed, except from the tasks themselves.
+*/
+class ThreadPool final {
+public:
+	/*
+		Schedules a function to be run on one of the worker threads.
+		Returns a Future for the value returned by the function.
+	*/
+	template<std::invocable Function_, class Result_ = std::invoke_result_t<std::decay_t<Function_>&>>
+		requires std::move_constructible<std::decay_t<Function_>> && (not std::is_reference_v<Result_>)
+	Future<Result_> submit(Function_&& function) {
+		auto const task = new detail::FunctionTask<std::decay_t<Function_>, Result_>{std::forward<Function_>(function)};
+		schedule_(task);
+		return Future<Result_>{task};
+	}
+
+	/*
+		Calls function with every integer in range, distributing the integers between the worker threads and the calling thread.
+		The range is split into chunks of grain_size integers, which are handed out dynamically so that
+		uneven work is still balanced. A grain_size of 0 picks a size that gives every thread a few chunks.
+		Returns when function has been called for all integers.
+		If function throws, no further chunks are started and the first exception is rethrown.
+	*/
+	template<std::integral Value_, std::invocable<Value_> Function_>
+	void parallel_for(util::Range<Value_> const range, Function_&& function, std::size_t grain_size = 0) {
+		auto const first = *range.begin();
+		if (*range.end() <= first) {
+			return;
+		}
+		auto const count = static_cast<std::size_t>(*range.end() - first);
+
+		if (grain_size == 0) {
+			grain_size = std::max(count/((thread_count() + 1)*chunks_per_thread_), std::size_t{1});
+		}
+		auto const chunk_count = (count + grain_size - 1)/grain_size;
+
+		auto next_chunk = std::atomic<std::size_t>{};
+		auto const run_chunks = [&] {
+			for (auto chunk = next_chunk.fetch_add(1, std::memory_order::relaxed); chunk < chunk_count;
+				chunk = next_chunk.fetch_add(1, std::memory_order::relaxed))
+			{
+				auto const chunk_end = std::min((chunk + 1)*grain_size, count);
+				for (auto offset = chunk*grain_size; offset < chunk_end; ++offset) {
+					std::invoke(function, static_cast<Value_>(first + static_cast<Value_>(offset)));
+				}
+			}
+		};
+
+		auto helpers = std::vector<Future<void>>{};
+		auto const helper_count = std::min(thread_count(), chunk_count - 1);
+		helpers.reserve(helper_count);
+
+		auto exception = std::exception_ptr{};
+		try {
+			for (auto i = std::size_t{}; i < helper_count; ++i) {
+				helpers.push_back(submit([&] {
+					try {
+						run_chunks();
+					}
+					catch (...) {
+						next_chunk.store(chunk_count, std::memory_order::relaxed);
+						throw;
+					}
+				}));
+			}
+			run_chunks();
+		}
+		catch (...) {
+			exception = std::current_exception();
+			next_chunk.store(chunk_count, std::memory_order::relaxed);
+		}
+
+		// The helpers refer to this stack frame, so all of them have to finish before anything is rethrown.
+		for (auto const& helper : helpers) {
+			helper.wait();
+		}
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+		for (auto& helper : helpers) {
+			helper.get();
+		}
+	}
+
+	/*
+		Calls function with every range in a recursive range such as an avo::Node tree, including the root,
+		distributing subtrees between the worker threads. 
+		A range is always passed to function before its children, but there is no order between other ranges.
+		Each task visits grain_size ranges before it splits off half of the siblings that it has left to visit
+		into a new task, so only trees that are larger than grain_size are processed in parallel.
+		A grain_size of 0 uses a default.
+		The tree must not be changed during the traversal.
+		If function throws, the exception is rethrown once the tasks that have already started have finished.
+	*/
+	template<util::IsRecursiveRange Range_, std::invocable<Range_&> Function_>
+	void parallel_for_each_subtree(Range_& root, Function_&& function, std::size_t const grain_size = 0) {
+		static_cast<void>(parallel_reduce_subtree(root, 
+			[&function](Range_& range) {
+				std::invoke(function, range);
+				return std::monostate{};
+			},
+			[](std::monostate, std::monostate) { return std::monostate{}; },
+			grain_size
+		));
+	}
+	/*
+		Transforms every range in a recursive range such as an avo::Node tree and reduces the results in post-order,
+		distributing subtrees between the worker threads in the same way as parallel_for_each_subtree.
+		The value of a subtree is the transformed root reduced with the values of its child subtrees, in order.
+		For example, passing a function that returns the bounds of a node and a function that returns the union of two 
+		rectangles gives the bounds of the whole tree.
+		reduce must be associative, since the order in which the values are grouped depends on how the tree is split.
+		It does not need to be commutative.
+	*/
+	template<util::IsRecursiveRange Range_, std::invocable<Range_&> Transform_, class Reduce_,
+		class Value_ = std::invoke_result_t<Transform_&, Range_&>>
+		requires std::move_constructible<Value_> and std::is_invocable_r_v<Value_, Reduce_&, Value_, Value_>
+	[[nodiscard]]
+	Value_ parallel_reduce_subtree(Range_& root, Transform_&& transform, Reduce_&& reduce, std::size_t grain_size = 0) {
+		if (grain_size == 0) {
+			grain_size = default_subtree_grain_size_;
+		}
+		auto visited_count = std::size_t{};
+		return SubtreeReduction_<Range_, Transform_, Reduce_, Value_>{*this, transform, reduce, grain_size}
+			.reduce_subtree(root, visited_count);
+	}
+
+	/*
+		Returns the number of worker threads.
+	*/
+	[[nodiscard]]
+	std::size_t thread_count() const {
+		return workers_.size();
+	}
+
+	/*
+		Returns one less than the number of hardware threads, but at least 1.
+	*/
+	[[nodiscard]]
+	static std::size_t default_thread_count() {
+		return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	/*
+		Starts the worker threads.
+		A thread_count of 0 is treated as 1.
+	*/
+	explicit ThreadPool(std::size_t const thread_count = default_thread_count()) {
+		workers_.reserve(std::max(thread_count, std::size_t{1}));
+		for (auto i = std::size_t{}; i < std::max(thread_count, std::size_t{1}); ++i) {
+			workers_.push_back(std::make_unique<Worker_>(*this, i));
+		}
+		for (auto const& worker : workers_) {
+			worker->thread = std::jthread{[this, worker = worker.get()] { run_worker_(*worker); }};
+		}
+	}
+	~ThreadPool() {
+		is_stopping_.store(true, std::memory_order::seq_cst);
+		work_epoch_.fetch_add(1, std::memory_order::seq_cst);
+		work_epoch_.notify_all();
+
+		for (auto const& worker : workers_) {
+			worker->thread.join();
+		}
+	}
+
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+private:
+	friend bool detail::try_run_pending_task();
+	template<class>
+	friend class Future;
+
+	struct Worker_ {
+		ThreadPool& pool;
+		std::size_t index;
+		WorkStealingDeque<detail::PoolTask*> tasks;
+		std::jthread thread;
+
+		Worker_(ThreadPool& p_pool, std::size_t const p_index) :
+			pool{p_pool},
+			index{p_index}
+		{}
+	};
+
+	static constexpr auto chunks_per_thread_ = std::size_t{4};
+	static constexpr auto default_subtree_grain_size_ = std::size_t{64};
+
+	/*
+		The state of a parallel_reduce_subtree call that is shared by all of its tasks.
+	*/
+	template<class Range_, class Transform_, class Reduce_, class Value_>
+	struct SubtreeReduction_ {
+		using Iterator = std::ranges::iterator_t<Range_>;
+
+		ThreadPool& pool;
+		Transform_& transform;
+		Reduce_& reduce;
+		std::size_t grain_size;
+
+		/*
+			visited_count is the number of ranges that the calling task has visited since it last split off work.
+		*/
+		[[nodiscard]]
+		Value_ reduce_subtree(Range_& range, std::size_t& visited_count) {
+			auto value = std::invoke(transform, range);
+			++visited_count;
+			if (std::ranges::empty(range)) {
+				return value;
+			}
+			return std::invoke(reduce, std::move(value), reduce_children(std::ranges::begin(range), std::ranges::end(range), visited_count));
+		}
+		/*
+			Reduces the values of a non-empty sequence of sibling subtrees.
+		*/
+		[[nodiscard]]
+		Value_ reduce_children(Iterator const first, Iterator const last, std::size_t& visited_count) {
+			// Each split covers the children from where it was made to the previous split, 
+			// so the last one covers the earliest children.
+			auto splits = std::vector<Future<Value_>>{};
+			auto end = last;
+
+			auto value = std::optional<Value_>{};
+			try {
+				for (auto child = first; child != end; ++child) {
+					if (visited_count >= grain_size) {
+						if (auto const remaining = std::ranges::distance(child, end); remaining > 1) {
+							auto const split = std::ranges::next(child, (remaining + 1)/2);
+							splits.push_back(pool.submit([this, split, end] {
+								auto task_visited_count = std::size_t{};
+								return reduce_children(split, end, task_visited_count);
+							}));
+							end = split;
+							visited_count = 0;
+						}
+					}
+					auto child_value = reduce_subtree(*child, visited_count);
+					value = value ? std::invoke(reduce, std::move(*value), std::move(child_value)) : std::move(child_value);
+				}
+			}
+			catch (...) {
+				// The tasks refer to this traversal, so all of them have to finish before anything is rethrown.
+				for (auto const& split : splits) {
+					split.wait();
+				}
+				throw;
+			}
+
+			for (auto const& split : splits) {
+				split.wait();
+			}
+			for (auto& split : splits | std::views::reverse) {
+				value = std::invoke(reduce, std::move(*value), split.get());
+			}
+			return std::move(*value);
+		}
+	};
+
+	/*
+		The worker that the current thread is, if it is a worker of any pool.
+	*/
+	static inline thread_local Worker_* current_worker_ = nullptr;
+
+	void schedule_(detail::PoolTask* const task) {
+		if (current_worker_ and &current_worker_->pool == this) {
+			current_worker_->tasks.push(task);
+		}
+		else {
+			auto const lock = std::lock_guard{injection_mutex_};
+			injected_tasks_.push_back(task);
+		}
+		wake_worker_();
+	}
+	void wake_worker_() {
+		work_epoch_.fetch_add(1, std::memory_order::seq_cst);
+		if (sleeping_count_.load(std::memory_order::seq_cst) > 0) {
+			work_epoch_.notify_one();
+		}
+	}
+
+	[[nodiscard]]
+	detail::PoolTask* take_injected_task_() {
+		auto const lock = std::lock_guard{injection_mutex_};
+		if (injected_tasks_.empty()) {
+			return nullptr;
+		}
+		auto const task = injected_tasks_.front();
+		injected_tasks_.pop_front();
+		return task;
+	}
+
+	/*
+		Looks for a task in the worker's own deque first, then in the injection queue and then in the other workers' deques.
+	*/
+	[[nodiscard]]
+	detail::PoolTask* find_task_(Worker_& worker) {
+		if (auto const task = worker.tasks.take()) {
+			return *task;
+		}
+		if (auto const task = take_injected_task_()) {
+			return task;
+		}
+
+		for (auto offset = std::size_t{1}; offset < workers_.size(); ++offset) {
+			if (auto const task = workers_[(worker.index + offset) % workers_.size()]->tasks.steal()) {
+				return *task;
+			}
+		}
+		return nullptr;
+	}
+
+	void run_worker_(Worker_& worker) {
+		current_worker_ = &worker;
+
+		while (true) {
+			auto const epoch = work_epoch_.load(std::memory_order::seq_cst);
+
+			if (auto const task = find_task_(worker)) {
+				task->run();
+				continue;
+			}
+			if (is_stopping_.load(std::memory_order::seq_cst)) {
+				break;
+			}
+
+			sleeping_count_.fetch_add(1, std::memory_order::seq_cst);
+			work_epoch_.wait(epoch, std::memory_order::seq_cst);
+			sleeping_count_.fetch_sub(1, std::memory_order::seq_cst);
+		}
+
+		current_worker_ = nullptr;
+	}
+
+	std::vector<std::unique_ptr<Worker_>> workers_;
+
+	std::mutex injection_mutex_;
+	std::deque<detail::PoolTask*> injected_tasks_;
+
+	// Incremented whenever a task is scheduled, so that sleeping workers can tell that something changed.
+	alignas(cache_line_size) std::atomic<std::uint32_t> work_epoch_{};
+	std::atomic<std::size_t> sleeping_count_{};
+	std::atomic<bool> is_stopping_{};
+};
+
+inline bool detail::try_run_pending_task() {
+	auto const worker = ThreadPool::current_worker_;
+	if (not worker) {
+		return false;
+	}
+	if (auto const task = worker->pool.find_task_(*worker)) {
+		task->run();
+		return true;
+	}
+	return false;
+}
+
+template<class Result_>
+bool Future<Result_>::is_on_worker_thread_() {
+	return ThreadPool::current_worker_ != nullptr;
+}
+
+} // namespace avo::concurrency
+
+#endif
@@ -0,0 +1,456 @@
+#ifndef AVO_CONCURRENCY_TIMER_WHEEL_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_TIMER_WHEEL_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "../id.hpp"
+#include "channel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace avo::concurrency {
+
+/*
+	A hierarchical timing wheel, which keeps track of timers that expire at integer ticks.
+
+	There are level_count wheels of slot_count slots each. A slot in level L covers slot_count^L ticks, and a timer is put in
+	the lowest level where its expiry tick shares all higher digits (in base slot_count) with the current tick.
+	When the current tick reaches the start of a slot in a higher level, its timers are cascaded down to lower levels.
+	Each slot is an intrusive doubly linked list, so adding and cancelling a timer are constant time operations,
+	and advancing skips empty slots using a bit mask of the occupied slots in each level.
+	Timers too far in the future for the top level stay there and are placed again every time they are cascaded.
+
+	The wheel is not thread-safe; see TimerScheduler for a thread that drives one.
+	Timer nodes are reused, so timers that come and go constantly do not allocate once the wheel has warmed up,
+	apart from the map from Id to node that cancelling uses.
+*/
+template<std::move_constructible T>
+class TimerWheel final {
+public:
+	using Tick = std::uint64_t;
+
+	static constexpr auto slot_bits = 6;
+	static constexpr auto slot_count = std::size_t{1} << slot_bits;
+	static constexpr auto level_count = 4;
+
+	/*
+		Adds a timer that expires at the given tick. If that tick is not after the current tick, the timer expires
+		on the next call to advance that moves the wheel forward.
+		If there already is a timer with the same id, it is replaced without expiring.
+	*/
+	void add(Id const id, Tick const expiry, T message) {
+		auto const [position, is_inserted] = nodes_by_id_.try_emplace(id);
+		if (not is_inserted) {
+			unlink_(position->second);
+			free_node_(position->second);
+		}
+		auto node = allocate_node_();
+		node->id = id;
+		node->expiry = std::max(expiry, current_tick_ + 1);
+		node->message.emplace(std::move(message));
+		position->second = node;
+		place_(node);
+	}
+	/*
+		Removes the timer with the given id without it expiring.
+		Returns false if there is no such timer, for example because it has already expired.
+	*/
+	bool cancel(Id const id) {
+		auto const found = nodes_by_id_.find(id);
+		if (found == nodes_by_id_.end()) {
+			return false;
+		}
+		auto const node = found->second;
+		nodes_by_id_.erase(found);
+		unlink_(node);
+		free_node_(node);
+		return true;
+	}
+	[[nodiscard]]
+	bool contains(Id const id) const {
+		return nodes_by_id_.contains(id);
+	}
+
+	/*
+		Moves the current tick forward to target and calls expire(Id, T&&) for every timer that expired,
+		in order of expiry. Does nothing if target is not after the current tick.
+		Returns the number of timers that expired.
+	*/
+	template<std::invocable<Id, T&&> Function_>
+	std::size_t advance(Tick const target, Function_&& expire) {
+		auto expired_count = std::size_t{};
+		while (current_tick_ < target) {
+			if (nodes_by_id_.empty()) {
+				current_tick_ = target;
+				break;
+			}
+			current_tick_ = std::min(target, next_level_0_tick_());
+
+			if ((current_tick_ & slot_mask_) == 0) {
+				cascade_();
+			}
+			expired_count += expire_slot_(current_tick_ & slot_mask_, expire);
+		}
+		return expired_count;
+	}
+
+	/*
+		Returns a tick at which the wheel needs to be advanced next, or std::nullopt if there are no timers.
+		No timer expires before the returned tick, but the earliest one may expire later than it
+		if it is in a higher level, which is then cascaded at the returned tick.
+	*/
+	[[nodiscard]]
+	std::optional<Tick> next_event_tick() const {
+		if (nodes_by_id_.empty()) {
+			return std::nullopt;
+		}
+		auto result = std::numeric_limits<Tick>::max();
+		for (auto level = 0; level < level_count; ++level) {
+			auto const shift = slot_bits*level;
+			auto const digit = static_cast<int>((current_tick_ >> shift) & slot_mask_);
+			auto const level_start = current_tick_ >> shift << shift;
+
+			auto const later_slots = occupied_slots_[level] & ~(std::uint64_t{1} << digit) & (~std::uint64_t{} << digit);
+			if (later_slots) {
+				result = std::min(result, level_start + (static_cast<Tick>(std::countr_zero(later_slots) - digit) << shift));
+			}
+			else if (occupied_slots_[level]) {
+				// Only slots that come around in the next lap of this level.
+				auto const lap_start = (current_tick_ >> (shift + slot_bits) << (shift + slot_bits)) + (Tick{1} << (shift + slot_bits));
+				result = std::min(result, lap_start + (static_cast<Tick>(std::countr_zero(occupied_slots_[level])) << shift));
+			}
+		}
+		return result;
+	}
+
+	[[nodiscard]]
+	Tick current_tick() const {
+		return current_tick_;
+	}
+	/*
+		Returns the number of timers that have not expired or been cancelled.
+	*/
+	[[nodiscard]]
+	std::size_t size() const {
+		return nodes_by_id_.size();
+	}
+	[[nodiscard]]
+	bool empty() const {
+		return nodes_by_id_.empty();
+	}
+
+	explicit TimerWheel(Tick const start_tick = 0) :
+		current_tick_{start_tick}
+	{}
+
+	TimerWheel(TimerWheel&&) = default;
+	TimerWheel& operator=(TimerWheel&&) = default;
+
+	TimerWheel(TimerWheel const&) = delete;
+	TimerWheel& operator=(TimerWheel const&) = delete;
+
+private:
+	static constexpr auto slot_mask_ = Tick{slot_count - 1};
+
+	struct Node_ {
+		Id id;
+		Tick expiry;
+		std::optional<T> message;
+		Node_* previous;
+		Node_* next;
+		int level;
+		std::size_t slot;
+	};
+
+	[[nodiscard]]
+	Node_* allocate_node_() {
+		if (free_nodes_) {
+			return std::exchange(free_nodes_, free_nodes_->next);
+		}
+		return node_storage_.emplace_back(std::make_unique<Node_>()).get();
+	}
+	void free_node_(Node_* const node) {
+		node->message.reset();
+		node->next = free_nodes_;
+		free_nodes_ = node;
+	}
+
+	void place_(Node_* const node) {
+		// The highest base slot_count digit where the expiry differs from the current tick decides the level.
+		auto const level = std::min(
+			(static_cast<int>(std::bit_width(node->expiry ^ current_tick_)) - 1)/slot_bits,
+			level_count - 1
+		);
+		auto const slot = static_cast<std::size_t>((node->expiry >> (slot_bits*level)) & slot_mask_);
+
+		auto& head = slots_[level][slot];
+		node->level = level;
+		node->slot = slot;
+		node->previous = nullptr;
+		node->next = head;
+		if (head) {
+			head->previous = node;
+		}
+		head = node;
+		occupied_slots_[level] |= std::uint64_t{1} << slot;
+	}
+	void unlink_(Node_* const node) {
+		if (node->previous) {
+			node->previous->next = node->next;
+		}
+		else {
+			slots_[node->level][node->slot] = node->next;
+			if (not node->next) {
+				occupied_slots_[node->level] &= ~(std::uint64_t{1} << node->slot);
+			}
+		}
+		if (node->next) {
+			node->next->previous = node->previous;
+		}
+	}
+	/*
+		Detaches the list of timers in a slot.
+	*/
+	[[nodiscard]]
+	Node_* take_slot_(int const level, std::size_t const slot) {
+		occupied_slots_[level] &= ~(std::uint64_t{1} << slot);
+		return std::exchange(slots_[level][slot], nullptr);
+	}
+
+	/*
+		Returns the next tick after the current one that either has timers in level 0 or starts a new lap of level 0.
+	*/
+	[[nodiscard]]
+	Tick next_level_0_tick_() const {
+		auto const lap_start = current_tick_ & ~slot_mask_;
+		auto const next_digit = (current_tick_ & slot_mask_) + 1;
+		if (next_digit < slot_count) {
+			if (auto const later_slots = occupied_slots_[0] & (~std::uint64_t{} << next_digit)) {
+				return lap_start + static_cast<Tick>(std::countr_zero(later_slots));
+			}
+		}
+		return lap_start + slot_count;
+	}
+	/*
+		Called when the current tick has reached the start of a lap of level 0.
+		Moves the timers of the slots in higher levels that start at the current tick down to lower levels.
+	*/
+	void cascade_() {
+		for (auto level = 1; level < level_count; ++level) {
+			auto const slot = static_cast<std::size_t>((current_tick_ >> (slot_bits*level)) & slot_mask_);
+			for (auto node = take_slot_(level, slot); node;) {
+				place_(std::exchange(node, node->next));
+			}
+			if (slot != 0) {
+				break;
+			}
+		}
+	}
+	template<class Function_>
+	std::size_t expire_slot_(std::size_t const slot, Function_& expire) {
+		auto expired_count = std::size_t{};
+		for (auto node = take_slot_(0, slot); node;) {
+			auto const current = std::exchange(node, node->next);
+			if (current->expiry > current_tick_) {
+				// Can only happen to timers beyond the range of the top level that were cascaded down.
+				place_(current);
+				continue;
+			}
+			auto const id = current->id;
+			auto message = std::move(*current->message);
+			nodes_by_id_.erase(id);
+			free_node_(current);
+			expire(id, std::move(message));
+			++expired_count;
+		}
+		return expired_count;
+	}
+
+	Tick current_tick_;
+	std::array<std::array<Node_*, slot_count>, level_count> slots_{};
+	std::array<std::uint64_t, level_count> occupied_slots_{};
+	std::unordered_map<Id, Node_*> nodes_by_id_;
+
+	Node_* free_nodes_{};
+	std::vector<std::unique_ptr<Node_>> node_storage_;
+};
+
+//------------------------------
+
+/*
+	Runs a thread that drives a TimerWheel and sends the message of every timer that expires through a channel,
+	so that it is handled on the thread of the receiver. For example, the message can be a callback:
+		auto [sender, receiver] = create_channel<std::function<void()>>();
+		auto timers = TimerScheduler{std::move(sender)};
+		auto const id = timers.schedule_after(500ms, [] { blink_caret(); });
+		...
+		receiver.receive()();
+
+	Timers that expire at the same time are sent as one batch, see Sender::send_batch.
+	If the channel rejects some of the messages because it is full, they are kept and sent again every tick 
+	until the receiver has made room for them.
+	Timers never expire early, but can expire up to one tick late. Timers can be scheduled and cancelled from any thread,
+	which takes constant time apart from the locking. Cancelling a timer that has expired but whose message has
+	not been received yet returns false and does not take the message back.
+*/
+template<std::move_constructible T, IsMessageQueue<T> Queue_ = MessageQueue<T>>
+class TimerScheduler final {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/*
+		Schedules a message to be sent at a point in time, returning the id of the timer.
+	*/
+	Id schedule_at(Clock::time_point const time, T message) {
+		auto const id = Id::next();
+		auto const expiry = to_tick_(time - start_time_ + tick_duration_ - Clock::duration{1});
+		{
+			auto const lock = std::lock_guard{mutex_};
+			wheel_.add(id, expiry, std::move(message));
+			if (expiry < wake_tick_) {
+				wake_tick_ = expiry;
+				is_rescheduled_ = true;
+			}
+			else {
+				return id;
+			}
+		}
+		wake_.notify_one();
+		return id;
+	}
+	/*
+		Schedules a message to be sent after a delay, returning the id of the timer.
+	*/
+	template<class Representation_, class Period_>
+	Id schedule_after(std::chrono::duration<Representation_, Period_> const delay, T message) {
+		return schedule_at(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay), std::move(message));
+	}
+	/*
+		Cancels a timer so that its message is never sent.
+		Returns false if there is no such timer, for example because it has already expired.
+	*/
+	bool cancel(Id const id) {
+		auto const lock = std::lock_guard{mutex_};
+		return wheel_.cancel(id);
+	}
+
+	/*
+		Returns the number of timers that have neither expired nor been cancelled.
+	*/
+	[[nodiscard]]
+	std::size_t pending_count() const {
+		auto const lock = std::lock_guard{mutex_};
+		return wheel_.size();
+	}
+	[[nodiscard]]
+	Clock::duration tick_duration() const {
+		return tick_duration_;
+	}
+
+	static constexpr auto default_tick_duration = std::chrono::milliseconds{1};
+
+	explicit TimerScheduler(
+		Sender<T, Queue_> sender,
+		Clock::duration const tick_duration = default_tick_duration
+	) :
+		sender_{std::move(sender)},
+		tick_duration_{std::max(tick_duration, Clock::duration{1})},
+		thread_{[this](std::stop_token const stop_token) { run_(stop_token); }}
+	{}
+	/*
+		Stops the thread. The messages of timers that have not expired are destroyed without being sent.
+	*/
+	~TimerScheduler() {
+		thread_.request_stop();
+		wake_.notify_one();
+	}
+
+	TimerScheduler(TimerScheduler&&) = delete;
+	TimerScheduler& operator=(TimerScheduler&&) = delete;
+
+	TimerScheduler(TimerScheduler const&) = delete;
+	TimerScheduler& operator=(TimerScheduler const&) = delete;
+
+private:
+	using Tick_ = typename TimerWheel<T>::Tick;
+
+	[[nodiscard]]
+	Tick_ to_tick_(Clock::duration const time_since_start) const {
+		return static_cast<Tick_>(std::max(time_since_start, Clock::duration{})/tick_duration_);
+	}
+
+	void run_(std::stop_token const stop_token) {
+		auto expired = std::vector<T>{};
+
+		auto lock = std::unique_lock{mutex_};
+		while (not stop_token.stop_requested()) {
+			wheel_.advance(to_tick_(Clock::now() - start_time_), [&](Id, T&& message) {
+				expired.push_back(std::move(message));
+			});
+
+			if (not expired.empty()) {
+				lock.unlock();
+				auto const sent_count = sender_.send_batch(std::ranges::subrange{
+					std::make_move_iterator(expired.begin()), std::make_move_iterator(expired.end())
+				});
+				// Messages that the channel rejected are kept in order and sent again on the next tick.
+				expired.erase(expired.begin(), expired.begin() + static_cast<std::ptrdiff_t>(sent_count));
+				lock.lock();
+				if (expired.empty()) {
+					continue;
+				}
+			}
+
+			is_rescheduled_ = false;
+			auto next_tick = wheel_.next_event_tick();
+			if (not expired.empty()) {
+				next_tick = std::min(next_tick.value_or(std::numeric_limits<Tick_>::max()), 
+					to_tick_(Clock::now() - start_time_) + 1);
+			}
+			if (next_tick) {
+				wake_tick_ = *next_tick;
+				wake_.wait_until(lock, stop_token, start_time_ + tick_duration_*static_cast<Clock::rep>(*next_tick), [this] {
+					return is_rescheduled_;
+				});
+			}
+			else {
+				wake_tick_ = std::numeric_limits<Tick_>::max();
+				wake_.wait(lock, stop_token, [this] { return is_rescheduled_; });
+			}
+		}
+	}
+
+	Sender<T, Queue_> sender_;
+	Clock::time_point const start_time_{Clock::now()};
+	Clock::duration const tick_duration_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable_any wake_;
+	// Guarded by mutex_.
+	TimerWheel<T> wheel_;
+	// The tick that the thread sleeps until, guarded by mutex_.
+	Tick_ wake_tick_{};
+	// Set when a timer was added that expires before wake_tick_, guarded by mutex_.
+	bool is_rescheduled_{};
+
+	// Declared last so that everything else exists when the thread starts.
+	std::jthread thread_;
+};
+
+} // namespace avo::concurrency
+
+#endif
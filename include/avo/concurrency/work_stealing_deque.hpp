@@ -0,0 +1,194 @@
+#ifndef AVO_CONCURRENCY_WORK_STEALING_DEQUE_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_CONCURRENCY_WORK_STEALING_DEQUE_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "miscellaneous.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace avo::concurrency {
+
+/*
+	A lock-free, growable Chase-Lev deque.
+
+	One thread owns the deque and pushes and takes items at the bottom, last in first out.
+	Any other thread can steal items from the top, first in first out.
+	The owner only synchronizes with thieves when the deque has at most one item left,
+	so pushing and taking is cheap as long as the owner keeps busy with its own items.
+
+	The items are stored in std::atomic, so they need to be trivially copyable; typically they are pointers.
+	When the deque grows, the old ring buffers are kept alive until the deque is destroyed
+	because a thief may still be reading from them.
+
+	This is the version of the algorithm for weak memory models by Lê, Pop, Cohen and Zappa Nardelli.
+	See ThreadPool.
+*/
+template<class T>
+	requires std::is_trivially_copyable_v<T>
+class WorkStealingDeque final {
+public:
+	/*
+		Adds an item at the bottom of the deque.
+		Must only be called from the owner thread.
+	*/
+	void push(T const item) {
+		auto const bottom = bottom_.load(std::memory_order::relaxed);
+		auto const top = top_.load(std::memory_order::acquire);
+		auto buffer = buffer_.load(std::memory_order::relaxed);
+
+		if (bottom - top > static_cast<std::ptrdiff_t>(buffer->mask)) {
+			buffer = grow_(*buffer, top, bottom);
+		}
+
+		buffer->store(bottom, item);
+		// A release store rather than a release fence followed by a relaxed store, which is equivalent
+		// but is not understood by ThreadSanitizer.
+		bottom_.store(bottom + 1, std::memory_order::release);
+	}
+
+	/*
+		Removes the item at the bottom of the deque, which is the most recently pushed one.
+		Returns std::nullopt if the deque is empty.
+		Must only be called from the owner thread.
+	*/
+	[[nodiscard]]
+	std::optional<T> take() {
+		auto const bottom = bottom_.load(std::memory_order::relaxed) - 1;
+		auto const buffer = buffer_.load(std::memory_order::relaxed);
+		bottom_.store(bottom, std::memory_order::relaxed);
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+		auto top = top_.load(std::memory_order::relaxed);
+
+		if (top > bottom) {
+			bottom_.store(bottom + 1, std::memory_order::relaxed);
+			return std::nullopt;
+		}
+
+		auto const item = buffer->load(bottom);
+		if (top != bottom) {
+			return item;
+		}
+
+		// This was the last item, so there may be a thief competing for it.
+		auto const is_taken = top_.compare_exchange_strong(
+			top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed
+		);
+		bottom_.store(bottom + 1, std::memory_order::relaxed);
+
+		if (is_taken) {
+			return item;
+		}
+		return std::nullopt;
+	}
+
+	/*
+		Removes the item at the top of the deque, which is the least recently pushed one.
+		Returns std::nullopt if the deque is empty or if another thread took the item first.
+		Can be called from any thread.
+	*/
+	[[nodiscard]]
+	std::optional<T> steal() {
+		auto top = top_.load(std::memory_order::acquire);
+		std::atomic_thread_fence(std::memory_order::seq_cst);
+		auto const bottom = bottom_.load(std::memory_order::acquire);
+
+		if (top >= bottom) {
+			return std::nullopt;
+		}
+
+		auto const item = buffer_.load(std::memory_order::acquire)->load(top);
+		if (top_.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed)) {
+			return item;
+		}
+		return std::nullopt;
+	}
+
+	/*
+		Returns the number of items in the deque.
+		Items that are being pushed or taken by other threads may or may not be counted.
+	*/
+	[[nodiscard]]
+	std::size_t recent_size() const {
+		auto const top = top_.load(std::memory_order::acquire);
+		auto const bottom = bottom_.load(std::memory_order::acquire);
+		return static_cast<std::size_t>(std::max(bottom - top, std::ptrdiff_t{}));
+	}
+	/*
+		Returns whether the deque is currently empty.
+	*/
+	[[nodiscard]]
+	bool was_recently_empty() const {
+		return recent_size() == 0;
+	}
+
+	static constexpr auto default_initial_capacity = std::size_t{64};
+
+	/*
+		The initial capacity is rounded up to a power of two.
+	*/
+	explicit WorkStealingDeque(std::size_t const initial_capacity = default_initial_capacity) {
+		buffers_.push_back(std::make_unique<Buffer_>(std::bit_ceil(std::max(initial_capacity, std::size_t{1}))));
+		buffer_.store(buffers_.back().get(), std::memory_order::relaxed);
+	}
+
+	WorkStealingDeque(WorkStealingDeque&&) = delete;
+	WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+	WorkStealingDeque(WorkStealingDeque const&) = delete;
+	WorkStealingDeque& operator=(WorkStealingDeque const&) = delete;
+
+private:
+	/*
+		A ring buffer indexed with the ever-increasing top and bottom indices.
+	*/
+	struct Buffer_ {
+		std::size_t mask;
+		std::unique_ptr<std::atomic<T>[]> items;
+
+		[[nodiscard]]
+		T load(std::ptrdiff_t const index) const {
+			return items[static_cast<std::size_t>(index) & mask].load(std::memory_order::relaxed);
+		}
+		void store(std::ptrdiff_t const index, T const item) {
+			items[static_cast<std::size_t>(index) & mask].store(item, std::memory_order::relaxed);
+		}
+
+		explicit Buffer_(std::size_t const capacity) :
+			mask{capacity - 1},
+			items{std::make_unique<std::atomic<T>[]>(capacity)}
+		{}
+	};
+
+	/*
+		Called by the owner when the buffer is full.
+		Copies the items to a buffer with twice the capacity and publishes it.
+	*/
+	Buffer_* grow_(Buffer_ const& old_buffer, std::ptrdiff_t const top, std::ptrdiff_t const bottom) {
+		auto new_buffer = std::make_unique<Buffer_>((old_buffer.mask + 1)*2);
+		for (auto index = top; index != bottom; ++index) {
+			new_buffer->store(index, old_buffer.load(index));
+		}
+		auto const result = buffers_.emplace_back(std::move(new_buffer)).get();
+		buffer_.store(result, std::memory_order::release);
+		return result;
+	}
+
+	// Written by thieves and by the owner when taking the last item.
+	alignas(cache_line_size) std::atomic<std::ptrdiff_t> top_{};
+
+	// Written by the owner.
+	alignas(cache_line_size) std::atomic<std::ptrdiff_t> bottom_{};
+	std::atomic<Buffer_*> buffer_;
+	// Only used by the owner. Owns the current buffer and all retired ones.
+	std::vector<std::unique_ptr<Buffer_>> buffers_;
+};
+
+} // namespace avo::concurrency
+
+#endif
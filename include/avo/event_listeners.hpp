@@ -1,19 +1,73 @@
 #ifndef AVO_EVENT_LISTENERS_HPP_BJORN_SUNDIN_JUNE_2021
 #define AVO_EVENT_LISTENERS_HPP_BJORN_SUNDIN_JUNE_2021
 
+#include "util/inplace_function.hpp"
+#include "util/miscellaneous.hpp"
+#include "util/small_vector.hpp"
+
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include <functional>
+#include <iterator>
 #include <ranges>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace avo {
 
 template<class T>
 class EventListeners;
 
+/*
+	Refers to a listener that was added to an EventListeners instance, and is used to remove it again.
+	A handle to a listener that has been removed never refers to a listener that was added later.
+*/
+class ListenerHandle final {
+public:
+	/*
+		Returns whether the handle was returned by EventListeners::add. The listener may have been removed since.
+	*/
+	[[nodiscard]]
+	constexpr explicit operator bool() const {
+		return generation_;
+	}
+
+	[[nodiscard]]
+	constexpr bool operator==(ListenerHandle const&) const = default;
+
+	constexpr ListenerHandle() = default;
+
+private:
+	constexpr ListenerHandle(std::uint32_t const slot, std::uint32_t const generation) :
+		slot_{slot},
+		generation_{generation}
+	{}
+
+	std::uint32_t slot_{};
+	// Generations start at 1, so a default constructed handle never refers to a listener.
+	std::uint32_t generation_{};
+
+	template<class T>
+	friend class EventListeners;
+};
+
 /*
 	This is a class used to easily manage event listeners. Any type of callable can be a listener.
 	The return type and arguments have to be the same for all listeners added to one instance of EventListeners.
 
+	add returns a ListenerHandle which removes the listener in constant time, through a slot map 
+	from handles to positions in the listener array. subscribe returns a Subscription which removes 
+	the listener when it is destroyed. Removing a listener by passing the function itself searches all listeners.
+
+	Listeners may add and remove listeners while they are being notified. Such changes are buffered 
+	until the outermost notify_all returns: added listeners are not called by the notification in progress, 
+	and removed listeners that have not been called yet are skipped. Removed listeners are not destroyed 
+	before then either, so a listener can remove itself and keep using its captures.
+
 	This class is NOT thread safe and should only be used in one thread.
 	Use the avo::concurrency namespace for communication between threads.
 */
@@ -25,6 +79,65 @@ public:
 	
 	using Iterator = std::ranges::iterator_t<ContainerType>;
 	using ConstIterator = std::ranges::iterator_t<ContainerType const>;
+
+	/*
+		Removes a listener from the EventListeners instance when it is destroyed.
+		The EventListeners instance must outlive the Subscription and must not be moved while it exists.
+	*/
+	class Subscription final {
+	public:
+		[[nodiscard]]
+		ListenerHandle handle() const {
+			return handle_;
+		}
+		/*
+			Removes the listener now instead of when the subscription is destroyed.
+		*/
+		void unsubscribe() {
+			if (listeners_) {
+				listeners_->remove(handle_);
+				listeners_ = nullptr;
+			}
+		}
+		/*
+			Leaves the listener in place when the subscription is destroyed, and returns its handle.
+		*/
+		ListenerHandle release() {
+			listeners_ = nullptr;
+			return handle_;
+		}
+
+		Subscription() = default;
+		~Subscription() {
+			unsubscribe();
+		}
+
+		Subscription(Subscription&& other) noexcept :
+			listeners_{std::exchange(other.listeners_, nullptr)},
+			handle_{other.handle_}
+		{}
+		Subscription& operator=(Subscription&& other) noexcept {
+			if (this != &other) {
+				unsubscribe();
+				listeners_ = std::exchange(other.listeners_, nullptr);
+				handle_ = other.handle_;
+			}
+			return *this;
+		}
+		Subscription(Subscription const&) = delete;
+		Subscription& operator=(Subscription const&) = delete;
+
+	private:
+		Subscription(EventListeners& listeners, ListenerHandle const handle) :
+			listeners_{&listeners},
+			handle_{handle}
+		{}
+
+		EventListeners* listeners_{};
+		ListenerHandle handle_;
+
+		friend class EventListeners;
+	};
 	
 	[[nodiscard]]
 	Iterator begin() {
@@ -45,20 +158,44 @@ public:
 
 	[[nodiscard]]
 	std::size_t size() const {
-		return listeners_.size();
+		return listeners_.size() - removed_count_ + added_listeners_.size();
 	}
 	[[nodiscard]]
 	bool is_empty() const {
-		return listeners_.empty();
+		return size() == 0;
+	}
+	/*
+		Returns whether notify_all is currently being called.
+	*/
+	[[nodiscard]]
+	bool is_notifying() const {
+		return notify_depth_ > 0;
+	}
+	/*
+		Returns whether a handle refers to a listener that has not been removed.
+	*/
+	[[nodiscard]]
+	bool contains(ListenerHandle const handle) const {
+		return handle && handle.slot_ < slots_.size() && slots_[handle.slot_].generation == handle.generation_;
 	}
 
 	/*
 		Adds a listener to the EventListeners instance that will be called when nofity_all or operator() is called.
+		Returns a handle that can be passed to remove.
 		Equivalent to EventListeners::operator+=.
 	*/
-	void add(std::function<FunctionType> listener) 
+	ListenerHandle add(std::function<FunctionType> listener) 
 	{
-		listeners_.emplace_back(std::move(listener));
+		auto const slot = allocate_slot_();
+		if (is_notifying()) {
+			added_listeners_.emplace_back(std::move(listener));
+			added_slots_.push_back(slot);
+		}
+		else {
+			listeners_.emplace_back(std::move(listener));
+			listener_slots_.push_back(slot);
+		}
+		return ListenerHandle{slot, slots_[slot].generation};
 	}
 	/*
 		Adds a listener to the EventListeners instance that will be called when nofity_all or operator() is called.
@@ -69,19 +206,286 @@ public:
 		add(std::move(listener));
 		return *this;
 	}
+	/*
+		Adds a listener that is removed when the returned subscription is destroyed.
+	*/
+	[[nodiscard]]
+	Subscription subscribe(std::function<FunctionType> listener) 
+	{
+		return Subscription{*this, add(std::move(listener))};
+	}
+
+	/*
+		Removes the listener that a handle refers to, if it has not already been removed.
+		Returns whether a listener was removed.
+	*/
+	bool remove(ListenerHandle const handle) 
+	{
+		if (not contains(handle)) {
+			return false;
+		}
+		auto& slot = slots_[handle.slot_];
+		auto const index = slot.index;
 
+		if (is_notifying()) {
+			// The listener may be the one that is running, so it is only marked as removed and
+			// destroyed by apply_buffered_changes_ once the outermost notification has returned.
+			slot_at_(index) = removed_slot_;
+			++removed_count_;
+		}
+		else {
+			listeners_[index] = std::move(listeners_.back());
+			listener_slots_[index] = listener_slots_.back();
+			slots_[listener_slots_[index]].index = index;
+			listeners_.pop_back();
+			listener_slots_.pop_back();
+		}
+
+		// Done last since the slot of the removed listener was updated above if it was the last one.
+		slot.index = std::exchange(first_free_slot_, handle.slot_);
+		++slot.generation;
+		return true;
+	}
 	/*
 		Removes a listener from the EventListeners instance that matches the passed function.
+		Function pointers are compared by value, and other callables such as lambdas by their type.
 		Equivalent to EventListeners::operator-=.
 	*/
 	void remove(std::function<FunctionType> const& listener) 
 	{
-		auto const& listener_type = listener.target_type();
-		auto const found_position = std::ranges::find_if(listeners_, [&](auto const& listener_element) {
+		auto const matches = [&](std::function<FunctionType> const& listener_element) {
+			if (listener_element.target_type() != listener.target_type()) {
+				return false;
+			}
 			// template keyword is used to expicitly tell the compiler that target is a template method for
 			// std::function<FunctionType> and < shouldn't be parsed as the less-than operator
-			return listener_type == listener_element.target_type() &&
-				*(listener.template target<FunctionType>()) == *(listener_element.template target<FunctionType>());
+			auto const function_pointer = listener.template target<FunctionType*>();
+			return not function_pointer || *function_pointer == *listener_element.template target<FunctionType*>();
+		};
+
+		for (auto i = std::size_t{}, count = listeners_.size() + added_listeners_.size(); i < count; ++i) {
+			if (auto const slot = slot_at_(i); slot != removed_slot_ && matches(listener_at_(i))) {
+				remove(handle_at_(slot));
+				return;
+			}
+		}
+	}
+	/*
+		Removes a listener from the EventListeners instance that matches the passed function.
+		Equivalent to EventListeners::remove.
+	*/
+	EventListeners& operator-=(std::function<FunctionType> const& listener) 
+	{
+		remove(listener);
+		return *this;
+	}
+	/*
+		Removes the listener that a handle refers to.
+		Equivalent to EventListeners::remove.
+	*/
+	EventListeners& operator-=(ListenerHandle const handle) 
+	{
+		remove(handle);
+		return *this;
+	}
+
+	/*
+		Calls all of the listeners with event_arguments as arguments.
+		Equivalent to EventListeners::operator().
+	*/
+	void notify_all(Arguments_&& ... event_arguments) 
+	{
+		++notify_depth_;
+		// Also done if a listener throws, so that later changes are not buffered forever.
+		auto const cleanup = util::Cleanup{[this] {
+			if (--notify_depth_ == 0) {
+				apply_buffered_changes_();
+			}
+		}};
+		// listeners_ does not change size while notifying, since additions are buffered.
+		for (auto i = std::size_t{}, count = listeners_.size(); i < count; ++i) {
+			if (listener_slots_[i] != removed_slot_) {
+				listeners_[i](std::forward<Arguments_>(event_arguments)...);
+			}
+		}
+	}
+	/*
+		Calls all of the listeners with event_arguments as arguments.
+		Equivalent to EventListeners::notify_all.
+	*/
+	void operator()(Arguments_&& ... event_arguments) 
+	{
+		notify_all(std::forward<Arguments_>(event_arguments)...);
+	}
+
+private:
+	struct Slot_ {
+		// The index of the listener in listeners_ followed by added_listeners_, 
+		// or the next free slot if the slot is free.
+		std::uint32_t index;
+		std::uint32_t generation;
+	};
+
+	static constexpr auto no_free_slot_ = ~std::uint32_t{};
+	// Marks a listener that was removed while notifying, in listener_slots_ or added_slots_.
+	static constexpr auto removed_slot_ = ~std::uint32_t{};
+
+	[[nodiscard]]
+	std::uint32_t allocate_slot_() {
+		auto const index = static_cast<std::uint32_t>(listeners_.size() + added_listeners_.size());
+		if (first_free_slot_ == no_free_slot_) {
+			slots_.push_back(Slot_{.index = index, .generation = 1});
+			return static_cast<std::uint32_t>(slots_.size() - 1);
+		}
+		auto const slot = std::exchange(first_free_slot_, slots_[first_free_slot_].index);
+		slots_[slot].index = index;
+		return slot;
+	}
+	[[nodiscard]]
+	ListenerHandle handle_at_(std::uint32_t const slot) const {
+		return ListenerHandle{slot, slots_[slot].generation};
+	}
+	[[nodiscard]]
+	std::function<FunctionType>& listener_at_(std::size_t const index) {
+		return index < listeners_.size() ? listeners_[index] : added_listeners_[index - listeners_.size()];
+	}
+	[[nodiscard]]
+	std::uint32_t& slot_at_(std::size_t const index) {
+		return index < listener_slots_.size() ? listener_slots_[index] : added_slots_[index - listener_slots_.size()];
+	}
+
+	/*
+		Appends the listeners that were added while notifying and destroys the ones that were removed,
+		keeping the order of the rest.
+	*/
+	void apply_buffered_changes_() {
+		if (not added_listeners_.empty()) {
+			std::ranges::move(added_listeners_, std::back_inserter(listeners_));
+			listener_slots_.insert(listener_slots_.end(), added_slots_.begin(), added_slots_.end());
+			added_listeners_.clear();
+			added_slots_.clear();
+		}
+		if (removed_count_) {
+			auto kept_count = std::size_t{};
+			for (auto i = std::size_t{}; i < listeners_.size(); ++i) {
+				if (listener_slots_[i] != removed_slot_) {
+					if (kept_count != i) {
+						listeners_[kept_count] = std::move(listeners_[i]);
+						listener_slots_[kept_count] = listener_slots_[i];
+					}
+					slots_[listener_slots_[kept_count]].index = static_cast<std::uint32_t>(kept_count);
+					++kept_count;
+				}
+			}
+			listeners_.resize(kept_count);
+			listener_slots_.resize(kept_count);
+			removed_count_ = 0;
+		}
+	}
+
+	ContainerType listeners_;
+	// The slot of each listener in listeners_, or removed_slot_.
+	std::vector<std::uint32_t> listener_slots_;
+	// Listeners added while notifying, which are moved to listeners_ afterwards.
+	ContainerType added_listeners_;
+	std::vector<std::uint32_t> added_slots_;
+	// Number of listeners that were marked as removed while notifying.
+	std::size_t removed_count_{};
+	int notify_depth_{};
+
+	std::vector<Slot_> slots_;
+	std::uint32_t first_free_slot_{no_free_slot_};
+};
+
+//------------------------------
+
+template<class T, std::size_t listener_capacity_ = 4, std::size_t function_capacity_ = 4*sizeof(void*)>
+class InplaceEventListeners;
+
+/*
+	Similar to EventListeners, except that listeners are stored as util::InplaceFunction objects with 
+	function_capacity_ bytes of storage each, in a util::SmallVector with room for listener_capacity_ of them.
+	As long as there are no more listeners than that, adding listeners never allocates and 
+	notify_all goes through one contiguous block of memory inside the object.
+	Listeners that are too large for function_capacity_ are a compile error.
+
+	Unlike EventListeners, changes are not buffered during a notification, 
+	so listeners must not be added or removed while notify_all is being called.
+
+	There are no listener handles; listeners are removed by passing the function, and are compared 
+	with InplaceFunction::has_same_target so that lambdas are matched by their type.
+*/
+template<class Return_, class ... Arguments_, std::size_t listener_capacity_, std::size_t function_capacity_>
+class InplaceEventListeners<Return_(Arguments_...), listener_capacity_, function_capacity_> final {
+public:
+	using FunctionType = Return_(Arguments_...);
+	using ListenerType = util::InplaceFunction<FunctionType, function_capacity_>;
+	using ContainerType = util::SmallVector<ListenerType, listener_capacity_>;
+	
+	using Iterator = std::ranges::iterator_t<ContainerType>;
+	using ConstIterator = std::ranges::iterator_t<ContainerType const>;
+	
+	[[nodiscard]]
+	Iterator begin() {
+		return listeners_.begin();
+	}
+	[[nodiscard]]
+	ConstIterator begin() const {
+		return listeners_.begin();
+	}
+	[[nodiscard]]
+	Iterator end() {
+		return listeners_.end();
+	}
+	[[nodiscard]]
+	ConstIterator end() const {
+		return listeners_.end();
+	}
+
+	[[nodiscard]]
+	std::size_t size() const {
+		return listeners_.size();
+	}
+	[[nodiscard]]
+	bool is_empty() const {
+		return listeners_.empty();
+	}
+	/*
+		Returns whether notify_all is currently being called.
+	*/
+	[[nodiscard]]
+	bool is_notifying() const {
+		return notify_depth_ > 0;
+	}
+
+	/*
+		Adds a listener that will be called when nofity_all or operator() is called.
+		Equivalent to InplaceEventListeners::operator+=.
+	*/
+	void add(ListenerType listener) 
+	{
+		assert(not is_notifying());
+		listeners_.emplace_back(std::move(listener));
+	}
+	/*
+		Adds a listener that will be called when nofity_all or operator() is called.
+		Equivalent to InplaceEventListeners::add.
+	*/
+	InplaceEventListeners& operator+=(ListenerType listener) 
+	{
+		add(std::move(listener));
+		return *this;
+	}
+
+	/*
+		Removes a listener that matches the passed function.
+		Equivalent to InplaceEventListeners::operator-=.
+	*/
+	void remove(ListenerType const& listener) 
+	{
+		assert(not is_notifying());
+		auto const found_position = std::ranges::find_if(listeners_, [&](ListenerType const& listener_element) {
+			return listener_element.has_same_target(listener);
 		});
 
 		if (found_position != listeners_.end()) 
@@ -91,10 +495,10 @@ public:
 		}
 	}
 	/*
-		Removes a listener from the EventListeners instance that matches the passed function.
-		Equivalent to EventListeners::remove.
+		Removes a listener that matches the passed function.
+		Equivalent to InplaceEventListeners::remove.
 	*/
-	EventListeners& operator-=(std::function<FunctionType> const& listener) 
+	InplaceEventListeners& operator-=(ListenerType const& listener) 
 	{
 		remove(listener);
 		return *this;
@@ -102,17 +506,19 @@ public:
 
 	/*
 		Calls all of the listeners with event_arguments as arguments.
-		Equivalent to EventListeners::operator().
+		Equivalent to InplaceEventListeners::operator().
 	*/
 	void notify_all(Arguments_&& ... event_arguments) 
 	{
+		++notify_depth_;
+		auto const cleanup = util::Cleanup{[this] { --notify_depth_; }};
 		for (auto& listener : listeners_) {
 			listener(std::forward<Arguments_>(event_arguments)...);
 		}
 	}
 	/*
 		Calls all of the listeners with event_arguments as arguments.
-		Equivalent to EventListeners::notify_all.
+		Equivalent to InplaceEventListeners::notify_all.
 	*/
 	void operator()(Arguments_&& ... event_arguments) 
 	{
@@ -121,6 +527,211 @@ public:
 
 private:
 	ContainerType listeners_;
+	int notify_depth_{};
+};
+
+//------------------------------
+
+template<class T>
+class EventQueue;
+
+/*
+	Holds EventListeners together with a queue of pending notifications, which are only sent to 
+	the listeners when flush is called, typically once per frame.
+	Enqueuing arguments that are equal to a notification that is already pending does nothing, 
+	so N identical notifications between two flushes reach the listeners once.
+	Arguments that are not equality comparable are never coalesced.
+
+	This class is NOT thread safe and should only be used in one thread.
+*/
+template<class ... Arguments_>
+class EventQueue<void(Arguments_...)> final {
+public:
+	using FunctionType = void(Arguments_...);
+	using PendingType = std::tuple<std::remove_cvref_t<Arguments_>...>;
+
+	[[nodiscard]]
+	EventListeners<FunctionType>& listeners() {
+		return listeners_;
+	}
+	[[nodiscard]]
+	EventListeners<FunctionType> const& listeners() const {
+		return listeners_;
+	}
+
+	/*
+		Adds a notification to be sent to the listeners by the next call to flush, unless an equal one is already pending.
+		Returns whether it was added.
+	*/
+	template<class ... Value_>
+		requires std::constructible_from<PendingType, Value_&&...>
+	bool enqueue(Value_&& ... event_arguments) 
+	{
+		auto event = PendingType{std::forward<Value_>(event_arguments)...};
+		if constexpr (std::equality_comparable<PendingType>) {
+			// Few notifications are pending at a time, so a linear search is cheaper than hashing.
+			if (std::ranges::find(pending_, event) != pending_.end()) {
+				return false;
+			}
+		}
+		pending_.push_back(std::move(event));
+		return true;
+	}
+
+	/*
+		Sends all pending notifications to the listeners in the order they were enqueued.
+		Notifications that are enqueued by the listeners are sent by the next call to flush.
+		Calling flush from a listener while flushing does nothing and returns zero.
+		Returns the number of notifications that were sent.
+	*/
+	std::size_t flush() 
+	{
+		if (is_flushing_) {
+			return 0;
+		}
+		is_flushing_ = true;
+		// Also done if a listener throws, so that the notifications are not sent again.
+		auto const cleanup = util::Cleanup{[this] {
+			flushing_.clear();
+			is_flushing_ = false;
+		}};
+
+		// The buffers are swapped and not reallocated, so that flushing does not allocate in the steady state.
+		std::swap(pending_, flushing_);
+		for (auto& event : flushing_) {
+			[&]<std::size_t ... index_>(std::index_sequence<index_...>) {
+				listeners_.notify_all(std::forward<Arguments_>(std::get<index_>(event))...);
+			}(std::index_sequence_for<Arguments_...>{});
+		}
+		return flushing_.size();
+	}
+	/*
+		Returns whether flush is currently being called.
+	*/
+	[[nodiscard]]
+	bool is_flushing() const {
+		return is_flushing_;
+	}
+
+	/*
+		Returns the number of notifications that will be sent by the next call to flush.
+	*/
+	[[nodiscard]]
+	std::size_t pending_count() const {
+		return pending_.size();
+	}
+	/*
+		Discards all pending notifications.
+	*/
+	void clear() {
+		pending_.clear();
+	}
+
+private:
+	EventListeners<FunctionType> listeners_;
+	std::vector<PendingType> pending_;
+	std::vector<PendingType> flushing_;
+	bool is_flushing_{};
+};
+
+//------------------------------
+
+template<class EventVariant_>
+class VariantEventListeners;
+
+/*
+	Holds a separate EventListeners instance for every alternative of a std::variant of event types.
+	Notifying with a variant calls every listener of the alternative that the variant holds,
+	by indexing a table with the variant's index. No other listeners are looked at, so the cost of
+	dispatching does not depend on how many different event types have listeners.
+
+	This class is NOT thread safe and should only be used in one thread.
+*/
+template<class ... Event_>
+class VariantEventListeners<std::variant<Event_...>> final {
+public:
+	using Variant = std::variant<Event_...>;
+
+	/*
+		True for callables that can be called with exactly one of the event types.
+	*/
+	template<class Listener_>
+	static constexpr bool is_listener = (std::size_t{std::invocable<Listener_&, Event_ const&>} + ...) == 1;
+
+	/*
+		Returns the listeners of one of the event types.
+	*/
+	template<class T>
+	[[nodiscard]]
+	EventListeners<void(T const&)>& listeners() {
+		return std::get<EventListeners<void(T const&)>>(listeners_);
+	}
+	template<class T>
+	[[nodiscard]]
+	EventListeners<void(T const&)> const& listeners() const {
+		return std::get<EventListeners<void(T const&)>>(listeners_);
+	}
+
+	/*
+		Adds a listener to the listeners of the event type it can be called with.
+		Equivalent to VariantEventListeners::operator+=.
+	*/
+	template<class Listener_>
+		requires is_listener<std::remove_cvref_t<Listener_>>
+	void add(Listener_&& listener) 
+	{
+		std::get<listener_index_<std::remove_cvref_t<Listener_>>()>(listeners_)
+			.add(std::forward<Listener_>(listener));
+	}
+	/*
+		Adds a listener to the listeners of the event type it can be called with.
+		Equivalent to VariantEventListeners::add.
+	*/
+	template<class Listener_>
+		requires is_listener<std::remove_cvref_t<Listener_>>
+	VariantEventListeners& operator+=(Listener_&& listener) 
+	{
+		add(std::forward<Listener_>(listener));
+		return *this;
+	}
+
+	/*
+		Calls all of the listeners of the event type that event holds.
+		Equivalent to VariantEventListeners::operator().
+	*/
+	void notify_all(Variant const& event) 
+	{
+		assert(not event.valueless_by_exception());
+		dispatch_table_[event.index()](listeners_, event);
+	}
+	/*
+		Calls all of the listeners of the event type that event holds.
+		Equivalent to VariantEventListeners::notify_all.
+	*/
+	void operator()(Variant const& event) 
+	{
+		notify_all(event);
+	}
+
+private:
+	using Container_ = std::tuple<EventListeners<void(Event_ const&)>...>;
+
+	template<class Listener_>
+	static constexpr std::size_t listener_index_() {
+		constexpr auto is_invocable = std::array{std::invocable<Listener_&, Event_ const&>...};
+		return static_cast<std::size_t>(std::ranges::find(is_invocable, true) - is_invocable.begin());
+	}
+
+	template<std::size_t index_>
+	static void notify_alternative_(Container_& listeners, Variant const& event) {
+		std::get<index_>(listeners)(*std::get_if<index_>(&event));
+	}
+
+	static constexpr auto dispatch_table_ = []<std::size_t ... index_>(std::index_sequence<index_...>) {
+		return std::array{&notify_alternative_<index_>...};
+	}(std::index_sequence_for<Event_...>{});
+
+	Container_ listeners_;
 };
 
 } // namespace avo
@@ -3,6 +3,8 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
+
 namespace avo {
 
 /*
@@ -38,11 +40,12 @@ public:
 
 	/*
 		Generates a new unique ID, assuming all IDs are generated by this function.
+		Can be called from any thread.
 	*/
 	[[nodiscard]]
 	static Id next() {
-		static auto counter = value_type{};
-		return Id{++counter};
+		static constinit auto counter = std::atomic<value_type>{};
+		return Id{counter.fetch_add(1, std::memory_order::relaxed) + 1};
 	}
 
 private:
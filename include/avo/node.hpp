@@ -4,8 +4,12 @@
 #include "id.hpp"
 #include "util/miscellaneous.hpp"
 #include "util/recursive_range.hpp"
+#include "util/type_id.hpp"
 
-#include <any>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
 
 namespace avo {
 
@@ -18,6 +22,16 @@ namespace avo {
 	A node does not own its child nodes - child nodes are added to a node tree by constructing them with a reference to its parent. 
 	This means that nodes can be stored in any way you wish; on the stack or on the heap.
 
+	Every node knows its index in the child vector of its parent, so removing a node from its siblings is a swap-and-pop. 
+	The order of the siblings of a removed node may change.
+	The nodes of a tree share a hash index from IDs to nodes. Looking up an ID from the root of a tree takes expected 
+	constant time, but looking it up from another node checks every node in the whole tree with that ID by walking up 
+	its ancestors, so it takes time proportional to that number of nodes times their depth. 
+	IDs that are repeated many times across a tree, such as the same ID in every row of a list, are therefore 
+	better looked up by traversing a small subtree directly. Moving a node to another parent in the same tree takes constant time, 
+	but detaching a node or moving it to another tree takes time linear in the size of its subtree, 
+	since its descendants move to another index.
+
 	This type can be used to build a tree of software components.
 	Each component stores an instance of a Node constructed with its parent node.
 	This enables retrieval of other software components in the tree by their IDs.
@@ -110,6 +124,51 @@ private:
 		BaseIterator base_iterator_;
 	};
 	
+	/*
+		Iterates the nodes that are dirty or have dirty descendants, in depth-first pre-order.
+	*/
+	template<bool is_const>
+	class DirtyPathIterator_ {
+	public:
+		using value_type = Node;
+		using reference = util::MaybeConst<Node, is_const>&;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		DirtyPathIterator_& operator++() {
+			current_ = current_->next_on_dirty_path_(*root_);
+			return *this;
+		}
+		DirtyPathIterator_ operator++(int) {
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		[[nodiscard]]
+		reference operator*() const {
+			return *current_;
+		}
+
+		[[nodiscard]]
+		bool operator==(std::default_sentinel_t) const {
+			return current_ == nullptr;
+		}
+		[[nodiscard]]
+		bool operator==(DirtyPathIterator_ const&) const = default;
+
+		DirtyPathIterator_() = default;
+		explicit DirtyPathIterator_(util::MaybeConst<Node, is_const>& root) :
+			current_{root.is_on_dirty_path_() ? &root : nullptr},
+			root_{&root}
+		{}
+
+	private:
+		util::MaybeConst<Node, is_const>* current_{};
+		util::MaybeConst<Node, is_const>* root_{};
+	};
+
 public:
 	using Iterator = Iterator_<false>;
 	using ConstIterator = Iterator_<true>;
@@ -159,11 +218,28 @@ public:
 	}
 	[[nodiscard]]
 	Node const* root() const {
-		auto root = this;
-		while (auto const parent = root->parent()) {
-			root = parent;
+		return id_index_ ? id_index_->root : this;
+	}
+
+	/*
+		Returns the index of the node in the children of its parent, or zero if it has no parent.
+	*/
+	[[nodiscard]]
+	std::size_t index_in_parent() const {
+		return index_in_parent_;
+	}
+
+	/*
+		Returns the number of ancestors of the node.
+		This takes time proportional to the depth.
+	*/
+	[[nodiscard]]
+	std::size_t depth() const {
+		auto depth = std::size_t{};
+		for (auto ancestor = parent_; ancestor; ancestor = ancestor->parent_) {
+			++depth;
 		}
-		return root;
+		return depth;
 	}
 
 	[[nodiscard]]
@@ -176,6 +252,8 @@ public:
 	}
 	/*
 		Sets the parent of the node.
+		This takes constant time if the new parent is in the same tree, 
+		otherwise time linear in the size of the subtree of the node.
 		Returns a reference to this node.
 	*/
 	Node& parent(Node& parent) {
@@ -183,11 +261,11 @@ public:
 			detach();
 		}
 		else {
-			remove_from_parent_();
-			
-			parent_ = &parent;
+			parent.link_child_(*this, parent.get_or_create_id_index_());
 
-			add_to_parent_();
+			if (is_on_dirty_path_()) {
+				propagate_dirty_descendant_();
+			}
 		}
 		return *this;
 	}
@@ -205,45 +283,214 @@ public:
 		return id_;
 	}
 	Node& id(Id const new_id) {
-		id_ = new_id;
+		if (parent_) {
+			id_index_->erase(*this);
+			id_ = new_id;
+			id_index_->insert(*this);
+		}
+		else {
+			id_ = new_id;
+		}
 		return *this;
 	}
 
+	/*
+		Returns a descendant node with a specific id, or null if there is none.
+		From the root of a tree, this takes expected constant time. From other nodes, this takes time proportional 
+		to the number of nodes in the whole tree with the id times their depth.
+	*/
 	[[nodiscard]]
 	Node* find_by_id(Id const id) {
 		return const_cast<Node*>(static_cast<Node const*>(this)->find_by_id(id));
 	}
+	/*
+		Returns a descendant node with a specific id, or null if there is none.
+		From the root of a tree, this takes expected constant time. From other nodes, this takes time proportional 
+		to the number of nodes in the whole tree with the id times their depth.
+	*/
 	[[nodiscard]]
 	Node const* find_by_id(Id const id) const
 	{
-		if (auto const node = std::ranges::find(id_nodes_, id, &Node::id_);
-			node != id_nodes_.end())
-		{
-			return *node;
+		for (Node const* const node : id_bucket_(id)) {
+			if (is_ancestor_of_(*node)) {
+				return node;
+			}
 		}
 		return nullptr;
 	}
 
 	/*
-		Returns a view of all child nodes with a specific id.
+		Returns a view of all descendant nodes with a specific id.
+		Unless this is the root of the tree, iterating the view checks every node in the whole tree with the id, 
+		see find_by_id. The view is invalidated when the tree changes.
 	*/
 	[[nodiscard]]
 	std::ranges::view auto find_all_by_id(Id const id) {
-		return id_nodes_ | std::views::filter([id](Node* node) { return node->id() == id; })
+		return id_bucket_(id) | std::views::filter([this](Node* node) { return is_ancestor_of_(*node); })
 			| std::views::transform([](Node* node) -> Node& { return *node; });
 	}
 	/*
-		Returns a view of all child nodes with a specific id.
+		Returns a view of all descendant nodes with a specific id.
+		Unless this is the root of the tree, iterating the view checks every node in the whole tree with the id, 
+		see find_by_id. The view is invalidated when the tree changes.
 	*/
 	[[nodiscard]]
 	std::ranges::view auto find_all_by_id(Id const id) const {
-		return id_nodes_ | std::views::filter([id](Node* node) { return node->id() == id; })
+		return id_bucket_(id) | std::views::filter([this](Node* node) { return is_ancestor_of_(*node); })
 			| std::views::transform([](Node* node) -> Node const& { return *node; });
 	}
 
+	/*
+		Makes a range of nodes children of this node, in order, after the existing children.
+		The elements can be nodes or pointers to nodes, including smart pointers.
+		Nodes that already have a parent are moved, including nodes that are already children of this node.
+		The child vector is grown once and the ID index of the tree is updated in one pass, 
+		so this is faster than setting the parent of each node.
+		None of the nodes may be this node or one of its ancestors.
+	*/
+	template<std::ranges::input_range Range_> 
+		requires std::same_as<std::ranges::range_reference_t<Range_>, Node&> 
+			or requires (std::ranges::range_reference_t<Range_> element) { { *element } -> std::same_as<Node&>; }
+	Node& adopt(Range_&& nodes) {
+		if constexpr (std::ranges::sized_range<Range_>) {
+			children_.reserve(children_.size() + std::ranges::size(nodes));
+		}
+		auto const index = get_or_create_id_index_();
+		if constexpr (std::ranges::sized_range<Range_>) {
+			index->buckets.reserve(index->buckets.size() + std::ranges::size(nodes));
+		}
+
+		auto is_any_dirty = false;
+		for (auto&& element : nodes) {
+			auto& node = to_node_(element);
+			link_child_(node, index);
+			is_any_dirty = is_any_dirty or node.is_on_dirty_path_();
+		}
+
+		if (is_any_dirty and not has_dirty_descendant_) {
+			has_dirty_descendant_ = true;
+			propagate_dirty_descendant_();
+		}
+		return *this;
+	}
+	/*
+		Detaches all children of the node, making each of them the root of its own tree.
+		This is faster than detaching them one at a time.
+	*/
+	Node& detach_all() {
+		if (children_.empty()) {
+			return *this;
+		}
+		for (Node* const child : children_) {
+			child->leave_id_index_(false);
+			child->parent_ = nullptr;
+			child->index_in_parent_ = 0;
+		}
+		children_.clear();
+		if (not parent_) {
+			// The index is empty now.
+			id_index_ = nullptr;
+		}
+		return *this;
+	}
+
+	/*
+		Marks the node as dirty, meaning that it has changed in some way that consumers of the tree should react to,
+		for example by doing layout or repainting.
+		The ancestors of the node are marked as having a dirty descendant, stopping at the first one that already was.
+	*/
+	Node& mark_dirty() {
+		is_dirty_ = true;
+		propagate_dirty_descendant_();
+		return *this;
+	}
+	[[nodiscard]]
+	bool is_dirty() const {
+		return is_dirty_;
+	}
+	/*
+		Returns whether any descendant of the node has been marked as dirty since the last call to clear_dirty on it or an ancestor.
+		It may also return true if that descendant has since been moved out of the subtree.
+	*/
+	[[nodiscard]]
+	bool has_dirty_descendant() const {
+		return has_dirty_descendant_;
+	}
+	/*
+		Returns a view of the nodes in the subtree that are dirty or have dirty descendants, in depth-first pre-order.
+		Clean subtrees are skipped, so the traversal only costs as much as the paths down to the dirty nodes.
+		The dirty flags must not be changed during the traversal.
+	*/
+	[[nodiscard]]
+	std::ranges::view auto view_dirty_paths() {
+		return std::ranges::subrange{DirtyPathIterator_<false>{*this}, std::default_sentinel};
+	}
+	/*
+		Returns a view of the nodes in the subtree that are dirty or have dirty descendants, in depth-first pre-order.
+		Clean subtrees are skipped, so the traversal only costs as much as the paths down to the dirty nodes.
+		The dirty flags must not be changed during the traversal.
+	*/
+	[[nodiscard]]
+	std::ranges::view auto view_dirty_paths() const {
+		return std::ranges::subrange{DirtyPathIterator_<true>{*this}, std::default_sentinel};
+	}
+	/*
+		Clears the dirty flags of the node and all of its descendants, only visiting the dirty paths.
+		The ancestors of the node still consider it to have a dirty descendant, so this is usually called on the root.
+	*/
+	Node& clear_dirty() {
+		auto node = this;
+		while (true) {
+			node->is_dirty_ = false;
+			if (auto const child = node->find_child_on_dirty_path_(0)) {
+				node = child;
+				continue;
+			}
+			while (true) {
+				node->has_dirty_descendant_ = false;
+				if (node == this) {
+					return *this;
+				}
+				auto const parent = node->parent_;
+				if (auto const next = parent->find_child_on_dirty_path_(node->index_in_parent_ + 1)) {
+					node = next;
+					break;
+				}
+				node = parent;
+			}
+		}
+	}
+
+	/*
+		Calls a function with this node and then each of its descendants, in depth-first pre-order.
+		The function must not add, remove or move nodes in the subtree.
+	*/
+	template<std::invocable<Node&> Function_>
+	void for_each_in_subtree(Function_ const& function) {
+		walk_subtree_(*this, function, [](Node&) {});
+	}
+	/*
+		Calls a function with this node and then each of its descendants, in depth-first pre-order.
+		The function must not add, remove or move nodes in the subtree.
+	*/
+	template<std::invocable<Node const&> Function_>
+	void for_each_in_subtree(Function_ const& function) const {
+		walk_subtree_(*this, function, [](Node const&) {});
+	}
+
+	/*
+		Returns the exact type of the component associated with this node,
+		or a TypeId that does not identify a type if there is no component.
+	*/
+	[[nodiscard]]
+	util::TypeId component_type() const {
+		return component_type_;
+	}
+
 	/*
 		Returns the component associated with this node.
 		It's an arbitrary object that has been associated with it at construction.
+		Returns null if the component is not exactly of type Component_.
 	*/
 	template<class Component_>
 	[[nodiscard]]
@@ -253,6 +500,7 @@ public:
 	/*
 		Returns the component associated with this node.
 		It's an arbitrary object that has been associated with it at construction.
+		Returns null if the component is not exactly of type Component_.
 	*/
 	template<class Component_>
 	[[nodiscard]]
@@ -263,33 +511,35 @@ public:
 	template<class Component_> 
 	Node(Id const id, Component_& component) :
 		id_{id},
-		component_{&component}
+		component_{erase_component_type_(component)},
+		component_type_{util::TypeId::of<Component_>()}
 	{}
-	template<class Component_> 
-	Node(Id const id) :
+	explicit Node(Id const id) :
 		id_{id}
 	{}
 	template<class Component_> 
 	Node(Component_& component) :
-		component_{&component}
+		component_{erase_component_type_(component)},
+		component_type_{util::TypeId::of<Component_>()}
 	{}
 
 	template<class Component_> 
 	Node(Node& parent, Id const id, Component_& component) :
 		parent_{&parent},
 		id_{id},
-		component_{&component}
+		component_{erase_component_type_(component)},
+		component_type_{util::TypeId::of<Component_>()}
 	{
 		add_to_parent_();
 	}
 	template<class Component_> 
 	Node(Node& parent, Component_& component) :
 		parent_{&parent},
-		component_{&component}
+		component_{erase_component_type_(component)},
+		component_type_{util::TypeId::of<Component_>()}
 	{
 		add_to_parent_();
 	}
-	template<class Component_> 
 	Node(Node& parent, Id const id) :
 		parent_{&parent},
 		id_{id}
@@ -309,51 +559,278 @@ public:
 	Node& operator=(Node&& other) = delete;
 
 private:
+	template<class Component_>
+	static void* erase_component_type_(Component_& component) {
+		return const_cast<void*>(static_cast<void const volatile*>(&component));
+	}
 	template<class Component_>
 	Component_* get_component_() const {
-		if (component_.type() == typeid(Component_*)) {
-			return std::any_cast<Component_*>(component_);
+		if (component_type_ == util::TypeId::of<Component_>()) {
+			return static_cast<Component_*>(component_);
 		}
 		else {
 			return nullptr;
 		}
 	}
 
-	void remove_from_parent_() 
-	{
-		if (parent_) {
-			util::unordered_erase(parent_->children_, this);
+	/*
+		The ID index of a tree, shared by all of its nodes.
+		It maps IDs to every node in the tree except for the root.
+		Lookups from a node other than the root are scoped to its subtree by walking up from each node with the ID
+		towards the root, so reparenting within the tree never touches the index and lookups never write
+		to the tree. Const lookups can therefore run concurrently from several threads while the tree does not change.
+	*/
+	struct IdIndex_ {
+		std::unordered_map<Id, std::vector<Node*>> buckets;
+		Node* root;
+
+		void insert(Node& node) {
+			auto& bucket = buckets[node.id_];
+			node.index_in_id_bucket_ = bucket.size();
+			bucket.push_back(&node);
+		}
+		void erase(Node& node) {
+			auto const bucket = buckets.find(node.id_);
+			auto& nodes = bucket->second;
+			auto const moved = nodes.back();
+			nodes[node.index_in_id_bucket_] = moved;
+			moved->index_in_id_bucket_ = node.index_in_id_bucket_;
+			nodes.pop_back();
+			if (nodes.empty()) {
+				buckets.erase(bucket);
+			}
+		}
+	};
 
-			for (Node* const parent : util::view_parents(*this)) {
-				util::unordered_erase(parent->id_nodes_, this);
+	/*
+		Visits a node and all of its descendants in depth-first order, without recursion or allocation.
+		enter is called with a node before its descendants and exit after them.
+		The functions must not change the structure of the subtree.
+	*/
+	template<class Node_, class Enter_, class Exit_>
+	static void walk_subtree_(Node_& subtree, Enter_ const& enter, Exit_ const& exit) {
+		Node_* node = &subtree;
+		while (true) {
+			enter(*node);
+			if (not node->children_.empty()) {
+				node = node->children_.front();
+				continue;
+			}
+			while (true) {
+				exit(*node);
+				if (node == &subtree) {
+					return;
+				}
+				Node_* const parent = node->parent_;
+				if (auto const next = node->index_in_parent_ + 1; next < parent->children_.size()) {
+					node = parent->children_[next];
+					break;
+				}
+				node = parent;
+			}
+		}
+	}
+
+	/*
+		Returns the nodes in the tree with an ID, which are not necessarily in the subtree of this node.
+	*/
+	[[nodiscard]]
+	std::span<Node* const> id_bucket_(Id const id) const {
+		if (not id_index_ or children_.empty()) {
+			return {};
+		}
+		auto const bucket = id_index_->buckets.find(id);
+		if (bucket == id_index_->buckets.end()) {
+			return {};
+		}
+		return bucket->second;
+	}
+	/*
+		Returns whether a node from the ID index of the tree is a descendant of this node.
+		This takes time proportional to the depth of the node.
+	*/
+	[[nodiscard]]
+	bool is_ancestor_of_(Node const& node) const {
+		if (not parent_) {
+			// Every node in the index of a root's tree is a descendant of it.
+			return true;
+		}
+		for (auto ancestor = node.parent_; ancestor; ancestor = ancestor->parent_) {
+			if (ancestor == this) {
+				return true;
 			}
 		}
+		return false;
+	}
+
+	/*
+		Removes the node from the children of its parent and the node and its descendants from the ID index of the tree.
+		Unless the node is about to be attached to another parent, its descendants are moved to a new index for the subtree.
+	*/
+	void remove_from_parent_(bool const will_be_attached = false) 
+	{
+		if (not parent_) {
+			return;
+		}
+
+		remove_from_siblings_();
+		leave_id_index_(will_be_attached);
+	}
+	void remove_from_siblings_() {
+		auto& siblings = parent_->children_;
+		auto const last_sibling = siblings.back();
+		siblings[index_in_parent_] = last_sibling;
+		last_sibling->index_in_parent_ = index_in_parent_;
+		siblings.pop_back();
+		index_in_parent_ = 0;
 	}
+	/*
+		Removes the node and its descendants from the ID index of the tree, without changing the children of the parent.
+	*/
+	void leave_id_index_(bool const will_be_attached) {
+		auto const old_index = id_index_;
+
+		auto new_index = std::shared_ptr<IdIndex_>{};
+		if (not will_be_attached and not children_.empty()) {
+			new_index = std::make_shared<IdIndex_>();
+			new_index->root = this;
+		}
+
+		for_each_in_subtree([&](Node& node) {
+			old_index->erase(node);
+			if (new_index and &node != this) {
+				new_index->insert(node);
+			}
+			node.id_index_ = new_index;
+		});
+	}
+	/*
+		Adds the node to the children of its parent, and the node and its descendants to the ID index of the tree.
+		The node must not be in a tree.
+	*/
 	void add_to_parent_() {
-		if (parent_) {
-			parent_->children_.push_back(this);
+		if (not parent_) {
+			return;
+		}
 
-			for (Node* const parent : util::view_parents(*this)) {
-				parent->id_nodes_.push_back(this);
+		// link_child_ expects parent_ to be the parent that the node is linked to, if any.
+		auto& parent = *std::exchange(parent_, nullptr);
+		parent.link_child_(*this, parent.get_or_create_id_index_());
+
+		if (is_on_dirty_path_()) {
+			propagate_dirty_descendant_();
+		}
+	}
+	/*
+		Moves a node to the end of the children, which must not make it an ancestor of itself.
+		index must be the ID index of this tree. If the node already has a parent in this tree, 
+		it is only removed from its siblings, otherwise it and its descendants are moved to the index.
+	*/
+	void link_child_(Node& child, std::shared_ptr<IdIndex_> const& index) {
+		auto const is_in_same_tree = child.parent_ and child.id_index_ == index;
+		if (is_in_same_tree) {
+			child.remove_from_siblings_();
+		}
+		else {
+			child.remove_from_parent_(true);
+		}
+
+		child.parent_ = this;
+		child.index_in_parent_ = children_.size();
+		children_.push_back(&child);
+
+		if (not is_in_same_tree) {
+			child.for_each_in_subtree([&](Node& node) {
+				index->insert(node);
+				node.id_index_ = index;
+			});
+		}
+	}
+	[[nodiscard]]
+	std::shared_ptr<IdIndex_> get_or_create_id_index_() {
+		if (not id_index_) {
+			id_index_ = std::make_shared<IdIndex_>();
+			id_index_->root = this;
+		}
+		return id_index_;
+	}
+	template<class Element_>
+	[[nodiscard]]
+	static Node& to_node_(Element_& element) {
+		if constexpr (std::same_as<std::remove_cv_t<Element_>, Node>) {
+			return element;
+		}
+		else {
+			return *element;
+		}
+	}
+	[[nodiscard]]
+	bool is_on_dirty_path_() const {
+		return is_dirty_ or has_dirty_descendant_;
+	}
+	/*
+		Returns the first child from an index on that is dirty or has dirty descendants, or null.
+	*/
+	[[nodiscard]]
+	Node* find_child_on_dirty_path_(std::size_t const first_index) const {
+		if (not has_dirty_descendant_) {
+			return nullptr;
+		}
+		for (auto index = first_index; index < children_.size(); ++index) {
+			if (children_[index]->is_on_dirty_path_()) {
+				return children_[index];
 			}
 		}
+		return nullptr;
+	}
+	/*
+		Returns the node after this one in a pre-order traversal of the dirty paths in the subtree of root, or null.
+	*/
+	[[nodiscard]]
+	Node* next_on_dirty_path_(Node const& root) const {
+		if (auto const child = find_child_on_dirty_path_(0)) {
+			return child;
+		}
+		for (auto node = this; node != &root; node = node->parent_) {
+			if (auto const next = node->parent_->find_child_on_dirty_path_(node->index_in_parent_ + 1)) {
+				return next;
+			}
+		}
+		return nullptr;
+	}
+	void propagate_dirty_descendant_() {
+		for (auto ancestor = parent_; ancestor and not ancestor->has_dirty_descendant_; ancestor = ancestor->parent_) {
+			ancestor->has_dirty_descendant_ = true;
+		}
 	}
+
 	void remove_from_tree_() 
 	{
-		remove_from_parent_();
-		if (not children_.empty()) {
-			std::ranges::for_each(children_, &Node::detach);
-			children_.clear();
-			id_nodes_.clear();
+		if (parent_) {
+			remove_from_siblings_();
+			// The descendants leave the ID index in detach_all, and get indexes of their own.
+			id_index_->erase(*this);
+			parent_ = nullptr;
 		}
+		detach_all();
 	}
 
 	Node* parent_{};
 	ContainerType children_;
-	std::vector<Node*> id_nodes_;
+
+	std::size_t index_in_parent_{};
+
+	// Shared by every node in the tree. Null for a root without children.
+	std::shared_ptr<IdIndex_> id_index_;
+	std::size_t index_in_id_bucket_{};
+
+	bool is_dirty_{};
+	bool has_dirty_descendant_{};
 
 	Id id_{};
-	std::any component_{};
+	void* component_{};
+	// The exact type that component_ points to.
+	util::TypeId component_type_{};
 };
 
 template<class Component_>
@@ -390,6 +867,24 @@ std::ranges::view auto find_components_by_id(Node_& node, Id const id)
 		});
 }
 
+/*
+	Calls a function with every component of type Component_ in a subtree, including the component of its root.
+	The components are visited in depth-first pre-order.
+	Each node costs a pointer comparison, so this is suitable for traversals that run every frame.
+*/
+template<class Component_, class Node_, class Function_> 
+	requires std::same_as<std::remove_const_t<Node_>, Node> 
+		and std::invocable<Function_&, util::MaybeConst<Component_, std::is_const_v<Node_>>&>
+void for_each_component(Node_& subtree, Function_&& function)
+{
+	constexpr auto type = util::TypeId::of<Component_>();
+	subtree.for_each_in_subtree([&](Node_& node) {
+		if (node.component_type() == type) {
+			function(*node.template component<Component_>());
+		}
+	});
+}
+
 } // namespace avo
 
 #endif
@@ -0,0 +1,478 @@
+#ifndef AVO_NODE_ARENA_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_NODE_ARENA_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "id.hpp"
+#include "util/type_id.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+namespace avo {
+
+/*
+	Refers to a node in a NodeArena.
+*/
+class NodeHandle final {
+public:
+	/*
+		Returns whether the handle refers to a node, which may have been destroyed.
+	*/
+	[[nodiscard]]
+	constexpr explicit operator bool() const {
+		return generation_;
+	}
+
+	[[nodiscard]]
+	constexpr bool operator==(NodeHandle const&) const = default;
+
+	constexpr NodeHandle() = default;
+
+private:
+	constexpr NodeHandle(std::uint32_t const index, std::uint32_t const generation) :
+		index_{index},
+		generation_{generation}
+	{}
+
+	std::uint32_t index_{};
+	// Generations start at 1, so a default constructed handle never refers to a node.
+	std::uint32_t generation_{};
+
+	friend class NodeArena;
+};
+
+/*
+	A NodeArena stores many trees of nodes in structure-of-arrays layout, as an alternative to avo::Node.
+	Each node has a parent, an ID and optionally a pointer to a component, like avo::Node.
+	The nodes are referred to by handles, which are indices paired with generations,
+	so a handle to a destroyed node never refers to a node that has been created in its place.
+
+	The links of a node to its parent, first and last child and siblings are indices into arrays that the arena owns,
+	so traversals do not chase pointers around the heap. Nodes created in depth-first order are also laid out in that order.
+	Use reserve to build a whole tree without allocating, and clear to destroy every node without deallocating.
+
+	Unlike avo::Node, finding nodes by ID traverses the subtree, since that is a linear sweep over compact arrays
+	for the small trees that one screen of a user interface consists of.
+*/
+class NodeArena final {
+	using Index_ = std::uint32_t;
+	static constexpr auto no_index_ = std::numeric_limits<Index_>::max();
+
+public:
+	using Handle = NodeHandle;
+
+private:
+	/*
+		Iterates the children of a node or the nodes in a subtree in depth-first pre-order.
+	*/
+	template<bool is_subtree>
+	class Iterator_ {
+	public:
+		using value_type = Handle;
+		using reference = Handle;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::input_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		Iterator_& operator++() {
+			if constexpr (is_subtree) {
+				index_ = arena_->next_in_subtree_(index_, root_);
+			}
+			else {
+				index_ = arena_->next_siblings_[index_];
+			}
+			return *this;
+		}
+		Iterator_ operator++(int) {
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		[[nodiscard]]
+		Handle operator*() const {
+			return arena_->handle_(index_);
+		}
+
+		[[nodiscard]]
+		bool operator==(std::default_sentinel_t) const {
+			return index_ == no_index_;
+		}
+		[[nodiscard]]
+		bool operator==(Iterator_ const& other) const {
+			return index_ == other.index_;
+		}
+
+		Iterator_() = default;
+		Iterator_(NodeArena const& arena, Index_ const index, Index_ const root) :
+			arena_{&arena},
+			index_{index},
+			root_{root}
+		{}
+
+	private:
+		NodeArena const* arena_{};
+		Index_ index_{no_index_};
+		Index_ root_{no_index_};
+	};
+
+public:
+	/*
+		Creates a node as the last child of parent, or as a root node if parent is a null handle.
+	*/
+	Handle create(Handle const parent = {}, Id const id = {}) {
+		return create_(parent, id, nullptr, {});
+	}
+	/*
+		Creates a node with a component as the last child of parent, or as a root node if parent is a null handle.
+	*/
+	template<class Component_>
+	Handle create(Handle const parent, Id const id, Component_& component) {
+		return create_(parent, id, const_cast<void*>(static_cast<void const volatile*>(&component)),
+			util::TypeId::of<Component_>());
+	}
+
+	/*
+		Destroys a node and all of its descendants.
+	*/
+	void destroy(Handle const node) {
+		assert(contains(node));
+		unlink_(node.index_);
+		walk_(node.index_, [](Index_) {}, [this](Index_ const index) {
+			++generations_[index];
+			component_types_[index] = {};
+			next_siblings_[index] = free_index_;
+			free_index_ = index;
+			--size_;
+		});
+	}
+	/*
+		Destroys every node without releasing any memory.
+		The slots are reused in order, so a tree built again after a clear gets the same layout.
+	*/
+	void clear() {
+		auto const slot_count = static_cast<Index_>(generations_.size());
+		for (auto const index : std::views::iota(Index_{}, slot_count)) {
+			++generations_[index];
+			component_types_[index] = {};
+			next_siblings_[index] = index + 1;
+		}
+		if (slot_count) {
+			next_siblings_.back() = no_index_;
+			free_index_ = 0;
+		}
+		size_ = 0;
+	}
+	/*
+		Allocates memory for a number of nodes.
+	*/
+	void reserve(std::size_t const capacity) {
+		parents_.reserve(capacity);
+		first_children_.reserve(capacity);
+		last_children_.reserve(capacity);
+		next_siblings_.reserve(capacity);
+		previous_siblings_.reserve(capacity);
+		ids_.reserve(capacity);
+		components_.reserve(capacity);
+		component_types_.reserve(capacity);
+		generations_.reserve(capacity);
+	}
+
+	/*
+		Returns whether a handle refers to a node in the arena that has not been destroyed.
+	*/
+	[[nodiscard]]
+	bool contains(Handle const node) const {
+		return node.index_ < generations_.size() and generations_[node.index_] == node.generation_;
+	}
+	/*
+		Returns the number of nodes in the arena.
+	*/
+	[[nodiscard]]
+	std::size_t size() const {
+		return size_;
+	}
+	[[nodiscard]]
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	/*
+		Returns the parent of a node, or a null handle if it is a root node.
+	*/
+	[[nodiscard]]
+	Handle parent(Handle const node) const {
+		assert(contains(node));
+		return handle_(parents_[node.index_]);
+	}
+	/*
+		Moves a node and its descendants to the end of the children of new_parent.
+		new_parent must not be in the subtree of the node.
+	*/
+	void parent(Handle const node, Handle const new_parent) {
+		assert(contains(node) and contains(new_parent));
+		unlink_(node.index_);
+		link_(node.index_, new_parent.index_);
+	}
+	/*
+		Detaches a node from its parent, making it a root node.
+	*/
+	void detach(Handle const node) {
+		assert(contains(node));
+		unlink_(node.index_);
+	}
+	[[nodiscard]]
+	Handle root(Handle node) const {
+		assert(contains(node));
+		auto index = node.index_;
+		while (parents_[index] != no_index_) {
+			index = parents_[index];
+		}
+		return handle_(index);
+	}
+
+	/*
+		Returns a view of the handles of the children of a node.
+	*/
+	[[nodiscard]]
+	std::ranges::view auto children(Handle const node) const {
+		assert(contains(node));
+		return std::ranges::subrange{Iterator_<false>{*this, first_children_[node.index_], no_index_}, std::default_sentinel};
+	}
+	/*
+		Returns a view of the handles of a node and all of its descendants, in depth-first pre-order.
+	*/
+	[[nodiscard]]
+	std::ranges::view auto subtree(Handle const node) const {
+		assert(contains(node));
+		return std::ranges::subrange{Iterator_<true>{*this, node.index_, node.index_}, std::default_sentinel};
+	}
+	/*
+		Calls a function with the handle of a node and then each of its descendants, in depth-first pre-order.
+		The function must not create, destroy or move nodes.
+	*/
+	template<std::invocable<Handle> Function_>
+	void for_each_in_subtree(Handle const node, Function_ const& function) const {
+		assert(contains(node));
+		walk_(node.index_, [&](Index_ const index) { function(handle_(index)); }, [](Index_) {});
+	}
+
+	[[nodiscard]]
+	Id id(Handle const node) const {
+		assert(contains(node));
+		return ids_[node.index_];
+	}
+	void id(Handle const node, Id const new_id) {
+		assert(contains(node));
+		ids_[node.index_] = new_id;
+	}
+
+	/*
+		Returns a view of the handles of all descendants of a node with a specific ID.
+	*/
+	[[nodiscard]]
+	std::ranges::view auto find_all_by_id(Handle const node, Id const id) const {
+		return subtree(node) | std::views::drop(1)
+			| std::views::filter([this, id](Handle const found) { return ids_[found.index_] == id; });
+	}
+
+	/*
+		Returns the first descendant of a node with a specific ID in depth-first pre-order, or a null handle.
+	*/
+	[[nodiscard]]
+	Handle find_by_id(Handle const node, Id const id) const {
+		auto found = find_all_by_id(node, id);
+		if (auto const first = found.begin(); first != found.end()) {
+			return *first;
+		}
+		return {};
+	}
+
+	/*
+		Returns the exact type of the component of a node,
+		or a TypeId that does not identify a type if there is no component.
+	*/
+	[[nodiscard]]
+	util::TypeId component_type(Handle const node) const {
+		assert(contains(node));
+		return component_types_[node.index_];
+	}
+	/*
+		Returns the component of a node, or null if it is not exactly of type Component_.
+	*/
+	template<class Component_>
+	[[nodiscard]]
+	Component_* component(Handle const node) const {
+		assert(contains(node));
+		if (component_types_[node.index_] == util::TypeId::of<Component_>()) {
+			return static_cast<Component_*>(components_[node.index_]);
+		}
+		return nullptr;
+	}
+
+	/*
+		Calls a function with every component of type Component_ in the arena.
+		This is a linear sweep over the component types of all slots, in no particular tree order.
+	*/
+	template<class Component_, std::invocable<Component_&> Function_>
+	void for_each_component(Function_&& function) const {
+		constexpr auto type = util::TypeId::of<Component_>();
+		for (auto const index : std::views::iota(std::size_t{}, component_types_.size())) {
+			if (component_types_[index] == type) {
+				function(*static_cast<Component_*>(components_[index]));
+			}
+		}
+	}
+	/*
+		Calls a function with every component of type Component_ in a subtree, including the component of its root,
+		in depth-first pre-order.
+	*/
+	template<class Component_, std::invocable<Component_&> Function_>
+	void for_each_component(Handle const node, Function_&& function) const {
+		assert(contains(node));
+		constexpr auto type = util::TypeId::of<Component_>();
+		walk_(node.index_, [&](Index_ const index) {
+			if (component_types_[index] == type) {
+				function(*static_cast<Component_*>(components_[index]));
+			}
+		}, [](Index_) {});
+	}
+
+	NodeArena() = default;
+	explicit NodeArena(std::size_t const capacity) {
+		reserve(capacity);
+	}
+
+private:
+	[[nodiscard]]
+	Handle handle_(Index_ const index) const {
+		if (index == no_index_) {
+			return {};
+		}
+		return Handle{index, generations_[index]};
+	}
+
+	Handle create_(Handle const parent, Id const id, void* const component, util::TypeId const component_type) {
+		assert(not parent or contains(parent));
+
+		auto index = free_index_;
+		if (index == no_index_) {
+			index = static_cast<Index_>(parents_.size());
+			parents_.push_back(no_index_);
+			first_children_.push_back(no_index_);
+			last_children_.push_back(no_index_);
+			next_siblings_.push_back(no_index_);
+			previous_siblings_.push_back(no_index_);
+			ids_.push_back(id);
+			components_.push_back(component);
+			component_types_.push_back(component_type);
+			generations_.push_back(1);
+		}
+		else {
+			free_index_ = next_siblings_[index];
+			parents_[index] = no_index_;
+			first_children_[index] = no_index_;
+			last_children_[index] = no_index_;
+			next_siblings_[index] = no_index_;
+			previous_siblings_[index] = no_index_;
+			ids_[index] = id;
+			components_[index] = component;
+			component_types_[index] = component_type;
+		}
+		++size_;
+
+		if (parent) {
+			link_(index, parent.index_);
+		}
+		return Handle{index, generations_[index]};
+	}
+
+	void link_(Index_ const index, Index_ const parent) {
+		parents_[index] = parent;
+		if (auto const last = last_children_[parent]; last == no_index_) {
+			first_children_[parent] = index;
+		}
+		else {
+			next_siblings_[last] = index;
+			previous_siblings_[index] = last;
+		}
+		last_children_[parent] = index;
+	}
+	void unlink_(Index_ const index) {
+		auto const parent = parents_[index];
+		if (parent == no_index_) {
+			return;
+		}
+		auto const previous = previous_siblings_[index];
+		auto const next = next_siblings_[index];
+		(previous == no_index_ ? first_children_[parent] : next_siblings_[previous]) = next;
+		(next == no_index_ ? last_children_[parent] : previous_siblings_[next]) = previous;
+		parents_[index] = no_index_;
+		previous_siblings_[index] = no_index_;
+		next_siblings_[index] = no_index_;
+	}
+
+	[[nodiscard]]
+	Index_ next_in_subtree_(Index_ index, Index_ const root) const {
+		if (first_children_[index] != no_index_) {
+			return first_children_[index];
+		}
+		while (index != root) {
+			if (next_siblings_[index] != no_index_) {
+				return next_siblings_[index];
+			}
+			index = parents_[index];
+		}
+		return no_index_;
+	}
+
+	/*
+		Visits a node and all of its descendants in depth-first order.
+		enter is called with a node before its descendants and exit after them.
+		exit may destroy the node it is called with, but neither function may change the structure of the rest of the subtree.
+	*/
+	template<class Enter_, class Exit_>
+	void walk_(Index_ const root, Enter_ const& enter, Exit_ const& exit) const {
+		auto index = root;
+		while (true) {
+			enter(index);
+			if (first_children_[index] != no_index_) {
+				index = first_children_[index];
+				continue;
+			}
+			while (true) {
+				auto const next_sibling = next_siblings_[index];
+				auto const parent = parents_[index];
+				exit(index);
+				if (index == root) {
+					return;
+				}
+				if (next_sibling != no_index_) {
+					index = next_sibling;
+					break;
+				}
+				index = parent;
+			}
+		}
+	}
+
+	std::vector<Index_> parents_;
+	std::vector<Index_> first_children_;
+	std::vector<Index_> last_children_;
+	std::vector<Index_> next_siblings_;
+	std::vector<Index_> previous_siblings_;
+	std::vector<Id> ids_;
+	std::vector<void*> components_;
+	std::vector<util::TypeId> component_types_;
+	std::vector<std::uint32_t> generations_;
+
+	// The first slot of the free list, which is linked through next_siblings_.
+	Index_ free_index_{no_index_};
+	std::size_t size_{};
+};
+
+} // namespace avo
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef AVO_TRACING_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_TRACING_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace avo::tracing {
+
+using Clock = std::chrono::steady_clock;
+
+/*
+	The points in the life of an input event and a frame that can be traced.
+*/
+enum class Point {
+	// The thread that owns a window received an event from the window thread.
+	EventReceived,
+	// An EventManager has notified the listeners of an event.
+	EventDispatched,
+	// A frame was presented on the screen.
+	FramePresented,
+};
+
+[[nodiscard]]
+constexpr std::string_view get_point_name(Point const point) {
+	switch (point) {
+		case Point::EventReceived: return "Event received";
+		case Point::EventDispatched: return "Event dispatched";
+		case Point::FramePresented: return "Frame presented";
+	}
+	return {};
+}
+
+struct Record {
+	Point point;
+	// What the point is about, for example the type of an event. Must refer to a string literal.
+	std::string_view name;
+	Clock::time_point time;
+	// The time that the input which led to this point happened, if known.
+	std::optional<Clock::time_point> source_time;
+	std::thread::id thread;
+};
+
+/*
+	Collects trace records from any number of threads, and writes them in the Chrome trace event JSON format,
+	which can be opened in Perfetto or chrome://tracing.
+
+	Every record becomes an instant event. Records with a source time also become a duration event from the
+	source time to the time of the record, which shows how long an event waited before being received or dispatched.
+	Each presented frame also gets a duration event from the oldest input that was dispatched since the previous
+	frame, which is the input-to-present latency of that frame.
+*/
+class Recorder final {
+public:
+	void record(Point const point, std::string_view const name, std::optional<Clock::time_point> const source_time = {})
+	{
+		add(Record{
+			.point = point,
+			.name = name,
+			.time = Clock::now(),
+			.source_time = source_time,
+			.thread = std::this_thread::get_id(),
+		});
+	}
+	/*
+		Adds a record whose time was measured elsewhere.
+	*/
+	void add(Record const& record) {
+		auto const lock = std::scoped_lock{mutex_};
+		records_.push_back(record);
+	}
+
+	/*
+		Returns a copy of the records so far, in the order they were recorded.
+	*/
+	[[nodiscard]]
+	std::vector<Record> records() const {
+		auto const lock = std::scoped_lock{mutex_};
+		return records_;
+	}
+	void clear() {
+		auto const lock = std::scoped_lock{mutex_};
+		records_.clear();
+	}
+
+	void write_chrome_trace(std::ostream& stream) const
+	{
+		auto const records = this->records();
+
+		// Source times can be earlier than the first record.
+		auto start_time = Clock::time_point::max();
+		for (auto const& record : records) {
+			start_time = std::min({start_time, record.time, record.source_time.value_or(record.time)});
+		}
+
+		// Whole microseconds, since the default formatting of floating point numbers would round 
+		// long traces to a few significant digits and use exponent notation.
+		auto const to_microseconds = [&](Clock::time_point const time) {
+			return std::chrono::duration_cast<std::chrono::microseconds>(time - start_time).count();
+		};
+		auto write_event = [&, is_first = true](std::string_view const name, Point const point,
+			Record const& record, std::optional<Clock::time_point> const begin) mutable
+		{
+			stream << (std::exchange(is_first, false) ? "\n" : ",\n");
+			stream << R"({"name":")" << name << R"(","cat":")" << get_point_name(point)
+				<< R"(","pid":1,"tid":)" << (std::hash<std::thread::id>{}(record.thread) & 0xffff'ffff);
+			if (begin) {
+				stream << R"(,"ph":"X","ts":)" << to_microseconds(*begin)
+					<< R"(,"dur":)" << to_microseconds(record.time) - to_microseconds(*begin) << '}';
+			}
+			else {
+				stream << R"(,"ph":"i","s":"t","ts":)" << to_microseconds(record.time) << '}';
+			}
+		};
+
+		stream << R"({"displayTimeUnit":"ms","traceEvents":[)";
+
+		auto oldest_unpresented_input = std::optional<Clock::time_point>{};
+		for (auto const& record : records)
+		{
+			write_event(record.name, record.point, record, std::nullopt);
+
+			if (record.point == Point::FramePresented) {
+				if (oldest_unpresented_input) {
+					write_event("Input to present", record.point, record, oldest_unpresented_input);
+					oldest_unpresented_input.reset();
+				}
+			}
+			else if (record.source_time) {
+				write_event(record.name, record.point, record, record.source_time);
+
+				if (record.point == Point::EventDispatched &&
+					(not oldest_unpresented_input || *record.source_time < *oldest_unpresented_input))
+				{
+					oldest_unpresented_input = record.source_time;
+				}
+			}
+		}
+		stream << "\n]}\n";
+	}
+	/*
+		Writes the trace to a file, see write_chrome_trace. Returns whether the file could be written.
+	*/
+	bool save_chrome_trace(std::string const& file_name) const {
+		auto file = std::ofstream{file_name};
+		write_chrome_trace(file);
+		return static_cast<bool>(file);
+	}
+
+	Recorder() = default;
+
+	Recorder(Recorder const&) = delete;
+	Recorder& operator=(Recorder const&) = delete;
+	Recorder(Recorder&&) = delete;
+	Recorder& operator=(Recorder&&) = delete;
+
+private:
+	mutable std::mutex mutex_;
+	std::vector<Record> records_;
+};
+
+//------------------------------
+
+namespace detail {
+
+inline std::atomic<Recorder*> current_recorder{};
+
+} // namespace detail
+
+/*
+	Sets the recorder that the library records trace points to, or stops tracing if it is null.
+	The recorder must outlive its use, so set it back to null before destroying it.
+*/
+inline void set_recorder(Recorder* const recorder) {
+	detail::current_recorder.store(recorder, std::memory_order::release);
+}
+[[nodiscard]]
+inline Recorder* get_recorder() {
+	return detail::current_recorder.load(std::memory_order::acquire);
+}
+
+/*
+	Records a trace point if there is a recorder. This is one atomic load when tracing is off.
+*/
+inline void record(Point const point, std::string_view const name, std::optional<Clock::time_point> const source_time = {}) {
+	if (auto const recorder = get_recorder()) {
+		recorder->record(point, name, source_time);
+	}
+}
+
+/*
+	Should be called by the renderer after presenting a frame, so that input-to-present latency can be traced.
+*/
+inline void record_frame_presented() {
+	record(Point::FramePresented, "Frame");
+}
+
+} // namespace avo::tracing
+
+#endif
@@ -4,11 +4,14 @@
 #include "util/concepts.hpp"
 #include "util/enumerate_view.hpp"
 #include "util/generate_view.hpp"
+#include "util/inplace_function.hpp"
 #include "util/int_range.hpp"
 #include "util/miscellaneous.hpp"
 #include "util/recursive_range.hpp"
+#include "util/small_vector.hpp"
 #include "util/static_map.hpp"
 #include "util/static_vector.hpp"
+#include "util/type_id.hpp"
 #include "util/unique_handle.hpp"
 
 #endif
@@ -0,0 +1,196 @@
+#ifndef AVO_UTILS_INPLACE_FUNCTION_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_UTILS_INPLACE_FUNCTION_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include "type_id.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace avo::util {
+
+template<class Signature_, std::size_t capacity_ = 4*sizeof(void*)>
+class InplaceFunction;
+
+/*
+	Like std::function, except that the callable is always stored inside the object in a buffer of capacity_ bytes,
+	so an InplaceFunction never allocates. Storing a callable that does not fit is a compile error.
+	Calling it is a single indirect call through a function pointer.
+*/
+template<class Return_, class ... Arguments_, std::size_t capacity_>
+class InplaceFunction<Return_(Arguments_...), capacity_> final {
+public:
+	static constexpr auto capacity = capacity_;
+
+	/*
+		Calls the stored callable, which must exist.
+	*/
+	Return_ operator()(Arguments_ ... arguments) const {
+		return invoke_(storage_, std::forward<Arguments_>(arguments)...);
+	}
+
+	[[nodiscard]]
+	explicit operator bool() const {
+		return invoke_ != nullptr;
+	}
+
+	/*
+		Returns the type of the stored callable, or a TypeId that does not identify a type if it is empty.
+	*/
+	[[nodiscard]]
+	TypeId target_type() const {
+		return target_type_;
+	}
+	/*
+		Returns a pointer to the stored callable if it is of type T, otherwise null.
+	*/
+	template<class T>
+	[[nodiscard]]
+	T* target() {
+		return target_type_ == TypeId::of<T>() ? std::launder(reinterpret_cast<T*>(storage_)) : nullptr;
+	}
+	template<class T>
+	[[nodiscard]]
+	T const* target() const {
+		return target_type_ == TypeId::of<T>() ? std::launder(reinterpret_cast<T const*>(storage_)) : nullptr;
+	}
+
+	/*
+		Returns whether two functions store callables of the same type that compare equal.
+		Callables that cannot be compared, such as lambdas, are considered equal if they are of the same type,
+		since every lambda expression has its own type.
+	*/
+	[[nodiscard]]
+	bool has_same_target(InplaceFunction const& other) const {
+		return target_type_ == other.target_type_ and
+			(not manage_ or manage_(Operation_::compare, const_cast<std::byte*>(storage_), other.storage_));
+	}
+
+	InplaceFunction() = default;
+
+	template<class Function_, class Stored_ = std::decay_t<Function_>>
+		requires (not std::same_as<Stored_, InplaceFunction>) and std::copy_constructible<Stored_>
+			and std::is_invocable_r_v<Return_, Stored_&, Arguments_...>
+	InplaceFunction(Function_&& function) :
+		invoke_{&invoke_stored_<Stored_>},
+		manage_{&manage_stored_<Stored_>},
+		target_type_{TypeId::of<Stored_>()}
+	{
+		static_assert(sizeof(Stored_) <= capacity_, "The callable is too large for the capacity of the InplaceFunction.");
+		static_assert(alignof(Stored_) <= alignof(std::max_align_t), "The callable is over-aligned.");
+		::new (static_cast<void*>(storage_)) Stored_(std::forward<Function_>(function));
+	}
+	~InplaceFunction() {
+		reset_();
+	}
+
+	InplaceFunction(InplaceFunction const& other) :
+		invoke_{other.invoke_},
+		manage_{other.manage_},
+		target_type_{other.target_type_}
+	{
+		if (manage_) {
+			manage_(Operation_::copy, storage_, other.storage_);
+		}
+	}
+	InplaceFunction& operator=(InplaceFunction const& other) {
+		if (this != &other) {
+			reset_();
+			if (other.manage_) {
+				other.manage_(Operation_::copy, storage_, other.storage_);
+			}
+			invoke_ = other.invoke_;
+			manage_ = other.manage_;
+			target_type_ = other.target_type_;
+		}
+		return *this;
+	}
+	InplaceFunction(InplaceFunction&& other) noexcept :
+		invoke_{other.invoke_},
+		manage_{other.manage_},
+		target_type_{other.target_type_}
+	{
+		if (manage_) {
+			manage_(Operation_::move, storage_, other.storage_);
+			other.clear_();
+		}
+	}
+	InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+		if (this != &other) {
+			reset_();
+			if (other.manage_) {
+				other.manage_(Operation_::move, storage_, other.storage_);
+			}
+			invoke_ = other.invoke_;
+			manage_ = other.manage_;
+			target_type_ = other.target_type_;
+			other.clear_();
+		}
+		return *this;
+	}
+
+private:
+	enum class Operation_ {
+		copy,
+		// Move constructs the destination from the source and destroys the source.
+		move,
+		destroy,
+		compare,
+	};
+
+	template<class Stored_>
+	static Return_ invoke_stored_(std::byte* const storage, Arguments_&& ... arguments) {
+		return std::invoke_r<Return_>(*std::launder(reinterpret_cast<Stored_*>(storage)), std::forward<Arguments_>(arguments)...);
+	}
+	template<class Stored_>
+	static bool manage_stored_(Operation_ const operation, std::byte* const destination, std::byte const* const source) {
+		switch (operation) {
+			case Operation_::copy:
+				::new (static_cast<void*>(destination)) Stored_(*std::launder(reinterpret_cast<Stored_ const*>(source)));
+				break;
+			case Operation_::move: {
+				auto& source_function = *std::launder(reinterpret_cast<Stored_*>(const_cast<std::byte*>(source)));
+				::new (static_cast<void*>(destination)) Stored_(std::move(source_function));
+				source_function.~Stored_();
+				break;
+			}
+			case Operation_::destroy:
+				std::launder(reinterpret_cast<Stored_*>(destination))->~Stored_();
+				break;
+			case Operation_::compare:
+				if constexpr (std::equality_comparable<Stored_>) {
+					return *std::launder(reinterpret_cast<Stored_ const*>(destination))
+						== *std::launder(reinterpret_cast<Stored_ const*>(source));
+				}
+				break;
+		}
+		return true;
+	}
+
+	void reset_() {
+		if (manage_) {
+			manage_(Operation_::destroy, storage_, nullptr);
+		}
+		clear_();
+	}
+	/*
+		Forgets the stored callable, which must already have been destroyed or moved from.
+	*/
+	void clear_() {
+		invoke_ = nullptr;
+		manage_ = nullptr;
+		target_type_ = {};
+	}
+
+	alignas(std::max_align_t) mutable std::byte storage_[capacity_];
+	Return_ (*invoke_)(std::byte*, Arguments_&& ...){};
+	bool (*manage_)(Operation_, std::byte*, std::byte const*){};
+	TypeId target_type_{};
+};
+
+} // namespace avo::util
+
+#endif
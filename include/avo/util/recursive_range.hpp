@@ -7,6 +7,7 @@
 
 #include <stack>
 #include <variant>
+#include <vector>
 
 namespace avo::util {
 
@@ -20,7 +21,7 @@ namespace avo::util {
 	The name of this member variable or function must be "parent".
 
 	Recursive ranges with parent references do not require a separate stack 
-	to keep track of parents when traversed recursively through a FlattenedView.
+	to keep track of parents when traversed recursively through a FlattenedView, PreOrderView or PostOrderView.
 */
 template<class T, bool has_parent_reference = false>
 concept IsRecursiveRange = std::ranges::range<T> && std::same_as<std::ranges::range_value_t<T>, std::remove_cvref_t<T>>
@@ -302,6 +303,328 @@ constexpr FlattenedView<T> operator|(T& range, decltype(flatten) const) {
 	return FlattenedView{range};
 }
 
+//------------------------------
+
+namespace detail {
+
+template<class T>
+concept HasIndexInParentFunction = requires (T range) {
+	{ range.index_in_parent() } -> std::convertible_to<std::size_t>;
+};
+
+} // namespace detail
+
+/*
+	Returns the index of a recursive range within its parent, which it must have.
+	Uses a member function index_in_parent if the range has one, otherwise the parent is searched.
+*/
+template<IsRecursiveRange<true> T>
+[[nodiscard]]
+constexpr std::size_t get_index_in_parent(T& range) {
+	if constexpr (detail::HasIndexInParentFunction<T>) {
+		return static_cast<std::size_t>(range.index_in_parent());
+	}
+	else {
+		auto& parent = *get_parent(range);
+		return static_cast<std::size_t>(std::ranges::distance(std::ranges::begin(parent), 
+			std::ranges::find_if(parent, [&range](auto& sibling) { return &sibling == &range; })));
+	}
+}
+
+namespace detail {
+
+/*
+	Returns the sibling after a range, or null if it is the last child of its parent or is the root of the traversal.
+*/
+template<IsRecursiveRange<true> T>
+[[nodiscard]]
+constexpr T* get_next_sibling(T& range, T* const root) {
+	if (&range == root) {
+		return nullptr;
+	}
+	auto& parent = *get_parent(range);
+	auto const next = std::ranges::next(std::ranges::begin(parent), 
+		static_cast<std::ranges::range_difference_t<T>>(get_index_in_parent(range) + 1));
+	return next == std::ranges::end(parent) ? nullptr : &*next;
+}
+
+template<IsRecursiveRange<true> T>
+[[nodiscard]]
+constexpr T* get_first_leaf(T* range) {
+	while (not std::ranges::empty(*range)) {
+		range = &*std::ranges::begin(*range);
+	}
+	return range;
+}
+
+} // namespace detail
+
+/*
+	A depth-first view of a recursive range with parent references, where every range comes before its children.
+	It is traversed through the parent references, so iterators are two pointers and never allocate.
+	Advancing is constant time if the range has an index_in_parent member function,
+	otherwise the siblings of a range are searched when leaving it.
+*/
+template<IsRecursiveRange<true> T>
+class PreOrderView final : public std::ranges::view_interface<PreOrderView<T>> {
+public:
+	class Iterator final {
+	public:
+		using value_type = std::remove_cv_t<T>;
+		using reference = T&;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		constexpr Iterator& operator++() {
+			if (not std::ranges::empty(*current_)) {
+				current_ = &*std::ranges::begin(*current_);
+				return *this;
+			}
+			while (current_ != root_) {
+				if (auto const next = detail::get_next_sibling(*current_, root_)) {
+					current_ = next;
+					return *this;
+				}
+				current_ = get_parent(*current_);
+			}
+			current_ = nullptr;
+			return *this;
+		}
+		constexpr Iterator operator++(int) {
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		[[nodiscard]]
+		constexpr reference operator*() const {
+			return *current_;
+		}
+
+		[[nodiscard]]
+		constexpr bool operator==(std::default_sentinel_t) const {
+			return current_ == nullptr;
+		}
+		[[nodiscard]]
+		constexpr bool operator==(Iterator const&) const = default;
+
+		constexpr Iterator() = default;
+		constexpr explicit Iterator(T* const root) :
+			current_{root},
+			root_{root}
+		{}
+
+	private:
+		T* current_{};
+		T* root_{};
+	};
+
+	[[nodiscard]]
+	constexpr Iterator begin() const {
+		return Iterator{range_};
+	}
+	[[nodiscard]]
+	constexpr std::default_sentinel_t end() const {
+		return {};
+	}
+
+	constexpr PreOrderView() = default;
+	constexpr explicit PreOrderView(T& range) :
+		range_{&range}
+	{}
+
+private:
+	T* range_{};
+};
+
+/*
+	A depth-first view of a recursive range with parent references, where every range comes after its children.
+	Like PreOrderView, it never allocates.
+*/
+template<IsRecursiveRange<true> T>
+class PostOrderView final : public std::ranges::view_interface<PostOrderView<T>> {
+public:
+	class Iterator final {
+	public:
+		using value_type = std::remove_cv_t<T>;
+		using reference = T&;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		constexpr Iterator& operator++() {
+			if (current_ == root_) {
+				current_ = nullptr;
+			}
+			else if (auto const next = detail::get_next_sibling(*current_, root_)) {
+				current_ = detail::get_first_leaf(next);
+			}
+			else {
+				current_ = get_parent(*current_);
+			}
+			return *this;
+		}
+		constexpr Iterator operator++(int) {
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		[[nodiscard]]
+		constexpr reference operator*() const {
+			return *current_;
+		}
+
+		[[nodiscard]]
+		constexpr bool operator==(std::default_sentinel_t) const {
+			return current_ == nullptr;
+		}
+		[[nodiscard]]
+		constexpr bool operator==(Iterator const&) const = default;
+
+		constexpr Iterator() = default;
+		constexpr explicit Iterator(T* const root) :
+			current_{detail::get_first_leaf(root)},
+			root_{root}
+		{}
+
+	private:
+		T* current_{};
+		T* root_{};
+	};
+
+	[[nodiscard]]
+	constexpr Iterator begin() const {
+		return Iterator{range_};
+	}
+	[[nodiscard]]
+	constexpr std::default_sentinel_t end() const {
+		return {};
+	}
+
+	constexpr PostOrderView() = default;
+	constexpr explicit PostOrderView(T& range) :
+		range_{&range}
+	{}
+
+private:
+	T* range_{};
+};
+
+/*
+	A breadth-first view of a recursive range, level by level.
+	The queue of ranges to visit is a vector that is passed in by the caller, 
+	so that it can be reused between traversals without allocating.
+	This is an input range: it can only be traversed once, and only one traversal can use a queue at a time.
+*/
+template<IsRecursiveRange T>
+class BreadthFirstView final : public std::ranges::view_interface<BreadthFirstView<T>> {
+public:
+	using Queue = std::vector<T*>;
+
+	class Iterator final {
+	public:
+		using value_type = std::remove_cv_t<T>;
+		using reference = T&;
+		using difference_type = std::ptrdiff_t;
+		using iterator_concept = std::input_iterator_tag;
+
+		constexpr Iterator& operator++() {
+			for (auto& child : *(*queue_)[position_]) {
+				queue_->push_back(&child);
+			}
+			++position_;
+			return *this;
+		}
+		constexpr void operator++(int) {
+			++*this;
+		}
+
+		[[nodiscard]]
+		constexpr reference operator*() const {
+			return *(*queue_)[position_];
+		}
+
+		[[nodiscard]]
+		constexpr bool operator==(std::default_sentinel_t) const {
+			return position_ == queue_->size();
+		}
+
+		constexpr Iterator() = default;
+		constexpr explicit Iterator(Queue& queue) :
+			queue_{&queue}
+		{}
+
+	private:
+		Queue* queue_{};
+		std::size_t position_{};
+	};
+
+	/*
+		Clears the queue and starts the traversal.
+	*/
+	[[nodiscard]]
+	constexpr Iterator begin() const {
+		queue_->clear();
+		queue_->push_back(range_);
+		return Iterator{*queue_};
+	}
+	[[nodiscard]]
+	constexpr std::default_sentinel_t end() const {
+		return {};
+	}
+
+	constexpr BreadthFirstView() = default;
+	constexpr BreadthFirstView(T& range, Queue& queue) :
+		range_{&range},
+		queue_{&queue}
+	{}
+
+private:
+	T* range_{};
+	Queue* queue_{};
+};
+
+/*
+	Returns a depth-first view over a recursive range with parent references, where ranges come before their children.
+	See avo::util::PreOrderView.
+*/
+template<IsRecursiveRange<true> T>
+[[nodiscard]]
+constexpr PreOrderView<T> view_pre_order(T& range) {
+	return PreOrderView{range};
+}
+/*
+	Returns a depth-first view over a recursive range with parent references, where ranges come after their children.
+	See avo::util::PostOrderView.
+*/
+template<IsRecursiveRange<true> T>
+[[nodiscard]]
+constexpr PostOrderView<T> view_post_order(T& range) {
+	return PostOrderView{range};
+}
+/*
+	Returns a breadth-first view over a recursive range, which uses queue as its buffer.
+	See avo::util::BreadthFirstView.
+*/
+template<IsRecursiveRange T>
+[[nodiscard]]
+constexpr BreadthFirstView<T> view_breadth_first(T& range, std::vector<T*>& queue) {
+	return BreadthFirstView{range, queue};
+}
+
 } // namespace avo::util
 
+namespace std::ranges {
+
+template<class T>
+constexpr auto enable_borrowed_range<avo::util::PreOrderView<T>> = true;
+template<class T>
+constexpr auto enable_borrowed_range<avo::util::PostOrderView<T>> = true;
+template<class T>
+constexpr auto enable_borrowed_range<avo::util::BreadthFirstView<T>> = true;
+
+} // namespace std::ranges
+
 #endif
@@ -0,0 +1,240 @@
+#ifndef AVO_UTILS_SMALL_VECTOR_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_UTILS_SMALL_VECTOR_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace avo::util {
+
+/*
+	A vector that stores up to inline_capacity_ elements inside the object itself and only allocates
+	when it grows beyond that. Like std::vector, the elements are always contiguous.
+	Moving a SmallVector whose elements are stored inline moves the elements one by one.
+*/
+template<class T, std::size_t inline_capacity_>
+class SmallVector final {
+	static_assert(inline_capacity_ > 0, "Use std::vector for vectors without inline storage.");
+
+public:
+	static constexpr auto inline_capacity = inline_capacity_;
+
+	using value_type = T;
+
+	template<class ... Arguments_>
+	T& emplace_back(Arguments_&& ... arguments) {
+		if (size_ == capacity_) {
+			return emplace_back_growing_(std::forward<Arguments_>(arguments)...);
+		}
+		auto const element = std::construct_at(data_ + size_, std::forward<Arguments_>(arguments)...);
+		++size_;
+		return *element;
+	}
+	void push_back(T const& element) {
+		emplace_back(element);
+	}
+	void push_back(T&& element) {
+		emplace_back(std::move(element));
+	}
+	void pop_back() {
+		std::destroy_at(data_ + --size_);
+	}
+	void clear() {
+		std::destroy_n(data_, size_);
+		size_ = 0;
+	}
+	/*
+		Makes sure that the vector can hold a number of elements without allocating again.
+	*/
+	void reserve(std::size_t const capacity) {
+		if (capacity > capacity_) {
+			grow_(capacity);
+		}
+	}
+
+	[[nodiscard]]
+	T* begin() {
+		return data_;
+	}
+	[[nodiscard]]
+	T const* begin() const {
+		return data_;
+	}
+	[[nodiscard]]
+	T* end() {
+		return data_ + size_;
+	}
+	[[nodiscard]]
+	T const* end() const {
+		return data_ + size_;
+	}
+	[[nodiscard]]
+	T* data() {
+		return data_;
+	}
+	[[nodiscard]]
+	T const* data() const {
+		return data_;
+	}
+
+	[[nodiscard]]
+	T& operator[](std::size_t const index) {
+		return data_[index];
+	}
+	[[nodiscard]]
+	T const& operator[](std::size_t const index) const {
+		return data_[index];
+	}
+	[[nodiscard]]
+	T& front() {
+		return data_[0];
+	}
+	[[nodiscard]]
+	T const& front() const {
+		return data_[0];
+	}
+	[[nodiscard]]
+	T& back() {
+		return data_[size_ - 1];
+	}
+	[[nodiscard]]
+	T const& back() const {
+		return data_[size_ - 1];
+	}
+
+	[[nodiscard]]
+	std::size_t size() const {
+		return size_;
+	}
+	[[nodiscard]]
+	std::size_t capacity() const {
+		return capacity_;
+	}
+	[[nodiscard]]
+	bool empty() const {
+		return size_ == 0;
+	}
+	/*
+		Returns whether the elements are stored inside the object rather than in allocated memory.
+	*/
+	[[nodiscard]]
+	bool is_inline() const {
+		return data_ == inline_data_();
+	}
+
+	SmallVector() = default;
+	SmallVector(std::initializer_list<T> const elements) {
+		reserve(elements.size());
+		for (auto const& element : elements) {
+			emplace_back(element);
+		}
+	}
+	~SmallVector() {
+		clear();
+		deallocate_();
+	}
+
+	SmallVector(SmallVector const& other) {
+		reserve(other.size_);
+		std::uninitialized_copy_n(other.data_, other.size_, data_);
+		size_ = other.size_;
+	}
+	SmallVector& operator=(SmallVector const& other) {
+		if (this != &other) {
+			clear();
+			reserve(other.size_);
+			std::uninitialized_copy_n(other.data_, other.size_, data_);
+			size_ = other.size_;
+		}
+		return *this;
+	}
+	SmallVector(SmallVector&& other) noexcept {
+		take_(other);
+	}
+	SmallVector& operator=(SmallVector&& other) noexcept {
+		if (this != &other) {
+			clear();
+			deallocate_();
+			take_(other);
+		}
+		return *this;
+	}
+
+private:
+	[[nodiscard]]
+	T* inline_data_() {
+		return std::launder(reinterpret_cast<T*>(inline_storage_));
+	}
+	[[nodiscard]]
+	T const* inline_data_() const {
+		return std::launder(reinterpret_cast<T const*>(inline_storage_));
+	}
+
+	/*
+		Like std::vector, the new element is constructed before the elements are moved to the new memory,
+		since the arguments may refer to one of the elements.
+	*/
+	template<class ... Arguments_>
+	T& emplace_back_growing_(Arguments_&& ... arguments) {
+		auto const capacity = std::max(capacity_*2, std::size_t{1});
+		auto const new_data = std::allocator<T>{}.allocate(capacity);
+		T* element;
+		try {
+			element = std::construct_at(new_data + size_, std::forward<Arguments_>(arguments)...);
+		}
+		catch (...) {
+			std::allocator<T>{}.deallocate(new_data, capacity);
+			throw;
+		}
+		move_to_(new_data, capacity);
+		++size_;
+		return *element;
+	}
+	void grow_(std::size_t const capacity) {
+		move_to_(std::allocator<T>{}.allocate(capacity), capacity);
+	}
+	/*
+		Moves the elements to newly allocated memory and releases the old memory.
+	*/
+	void move_to_(T* const new_data, std::size_t const capacity) {
+		std::uninitialized_move_n(data_, size_, new_data);
+		std::destroy_n(data_, size_);
+		deallocate_();
+		data_ = new_data;
+		capacity_ = capacity;
+	}
+	void deallocate_() {
+		if (not is_inline()) {
+			std::allocator<T>{}.deallocate(data_, capacity_);
+			data_ = inline_data_();
+			capacity_ = inline_capacity_;
+		}
+	}
+	/*
+		Takes the elements of another vector. This vector must be empty and must not have allocated memory.
+	*/
+	void take_(SmallVector& other) noexcept {
+		if (other.is_inline()) {
+			std::uninitialized_move_n(other.data_, other.size_, data_);
+			size_ = other.size_;
+			other.clear();
+		}
+		else {
+			data_ = std::exchange(other.data_, other.inline_data_());
+			size_ = std::exchange(other.size_, 0);
+			capacity_ = std::exchange(other.capacity_, inline_capacity_);
+		}
+	}
+
+	alignas(T) std::byte inline_storage_[sizeof(T)*inline_capacity_];
+	T* data_{inline_data_()};
+	std::size_t size_{};
+	std::size_t capacity_{inline_capacity_};
+};
+
+} // namespace avo::util
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef AVO_UTILS_TYPE_ID_HPP_BJORN_SUNDIN_OCTOBER_2026
+#define AVO_UTILS_TYPE_ID_HPP_BJORN_SUNDIN_OCTOBER_2026
+
+#include <functional>
+
+namespace avo::util {
+
+/*
+	Identifies a type without RTTI.
+	It is the address of a variable that exists once per type, so comparing two TypeIds is a pointer comparison
+	and TypeId::of can be used in constant expressions.
+	cv-qualified types are distinct from their unqualified types.
+	A default constructed TypeId does not identify any type.
+
+	Note that the same type can get different IDs in different shared libraries on some platforms.
+*/
+class TypeId final {
+public:
+	template<class T>
+	[[nodiscard]]
+	static constexpr TypeId of() {
+		return TypeId{&tag_<T>};
+	}
+
+	[[nodiscard]]
+	constexpr explicit operator bool() const {
+		return tag_address_;
+	}
+
+	[[nodiscard]]
+	constexpr bool operator==(TypeId const&) const = default;
+
+	constexpr TypeId() = default;
+
+private:
+	/*
+		Not const, since identical read-only constants can be folded into one address by 
+		the linker (for example with MSVC /OPT:ICF or -fmerge-all-constants), which would make TypeIds of different types equal.
+		The address is still a constant expression.
+	*/
+	template<class T>
+	static inline char tag_{};
+
+	constexpr explicit TypeId(char const* const tag_address) :
+		tag_address_{tag_address}
+	{}
+
+	char const* tag_address_{};
+
+	friend struct std::hash<TypeId>;
+};
+
+} // namespace avo::util
+
+template<>
+struct std::hash<avo::util::TypeId> {
+	std::size_t operator()(avo::util::TypeId const id) const {
+		return hash<char const*>{}(id.tag_address_);
+	}
+};
+
+#endif
@@ -1,13 +1,24 @@
 #ifndef AVO_WINDOW_HPP_BJORN_SUNDIN_JUNE_2021
 #define AVO_WINDOW_HPP_BJORN_SUNDIN_JUNE_2021
 
+#include "concurrency/channel_statistics.hpp"
+#include "concurrency/event_loop.hpp"
 #include "event_listeners.hpp"
 #include "graphics/miscellaneous.hpp"
 #include "math/miscellaneous.hpp"
 #include "math/vector2d.hpp"
+#include "tracing.hpp"
 #include "util/miscellaneous.hpp"
 
+#include <algorithm>
 #include <any>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
 namespace avo::window {
@@ -176,51 +187,106 @@ inline constexpr bool is_bit_flag<avo::window::StyleFlags> = true;
 
 namespace avo::window {
 
+/*
+	The type of the timestamp member that every event has, which is when the event happened according to the 
+	windowing system. It is the epoch of the clock if the platform does not provide a time for the event.
+*/
+using EventTime = tracing::Clock::time_point;
+
 namespace event {
 
 struct MouseMove {
 	math::Point<Dip> position;
 	math::Vector2d<Dip> movement;
+	EventTime timestamp;
 };
 struct MouseLeave {
 	math::Point<Dip> position;
 	math::Vector2d<Dip> movement;
+	EventTime timestamp;
 };
 struct MouseScroll {
 	math::Point<Dip> position;
 	float scroll_delta;
+	EventTime timestamp;
 };
 struct MouseDown {
 	math::Point<Dip> position;
 	MouseButton button;
 	bool is_double_click;
+	EventTime timestamp;
 };
 struct MouseUp {
 	math::Point<Dip> position;
 	MouseButton button;
+	EventTime timestamp;
 };
 struct KeyDown {
 	KeyboardKey key;
 	bool is_repeated;
+	EventTime timestamp;
 };
 struct KeyUp {
 	KeyboardKey key;
+	EventTime timestamp;
 };
+/*
+	The character is stored inline as UTF-8 instead of in a std::string, since it is at most 4 bytes long.
+	This keeps the event trivially copyable, so sending it never allocates.
+*/
 struct CharacterInput {
-	std::string character;
+	static constexpr auto max_size = std::size_t{4};
+
+	std::array<char, max_size> code_units;
+	std::uint8_t size;
 	bool is_repeated;
+	EventTime timestamp;
+
+	/*
+		Returns the UTF-8 encoded character.
+	*/
+	[[nodiscard]]
+	constexpr std::string_view character() const {
+		return {code_units.data(), size};
+	}
+	/*
+		Sets the UTF-8 encoded character, which is at most max_size bytes long.
+		Any code units beyond max_size are ignored.
+	*/
+	constexpr void character(std::string_view const character) {
+		size = static_cast<std::uint8_t>(std::min(character.size(), max_size));
+		std::ranges::copy(character.substr(0, size), code_units.begin());
+	}
+};
+struct FocusGain {
+	EventTime timestamp;
+};
+struct FocusLose {
+	EventTime timestamp;
 };
-struct FocusGain {};
-struct FocusLose {};
 struct SizeChange {
 	math::Size<Dip> size;
+	EventTime timestamp;
 };
 struct StateChange {
 	State state;
+	EventTime timestamp;
+};
+struct Closed {
+	EventTime timestamp;
 };
-struct Closed {};
 struct DpiChange {
 	float dpi;
+	EventTime timestamp;
+};
+/*
+	Relative motion of the pointing device before pointer acceleration, in device units.
+	It is sent while the window has focus, also when the pointer is outside of the window or cannot move further.
+	Only sent on Linux when the library is built with XInput2.
+*/
+struct RawMouseMove {
+	math::Vector2d<float> movement;
+	EventTime timestamp;
 };
 
 } // namespace event
@@ -239,9 +305,69 @@ using Event = std::variant<
 	event::SizeChange,
 	event::StateChange,
 	event::Closed,
-	event::DpiChange
+	event::DpiChange,
+	event::RawMouseMove
 >;
 
+/*
+	Merges an incoming event into a queued one if both are mouse movements of the same kind or both are size changes,
+	so that a consumer that falls behind receives one up-to-date event instead of many stale ones.
+	The movements of merged mouse movements are summed, and the timestamp of the first one is kept 
+	since that is how long the merged input has been waiting. Returns whether the events were merged.
+	This is the concurrency::CoalesceFunction of the channel that the window thread sends events through.
+*/
+inline bool merge_events(Event& queued, Event const& incoming) {
+	if (auto const incoming_move = std::get_if<event::MouseMove>(&incoming)) {
+		if (auto const queued_move = std::get_if<event::MouseMove>(&queued)) {
+			queued_move->position = incoming_move->position;
+			queued_move->movement += incoming_move->movement;
+			return true;
+		}
+	}
+	else if (auto const incoming_raw_move = std::get_if<event::RawMouseMove>(&incoming)) {
+		if (auto const queued_raw_move = std::get_if<event::RawMouseMove>(&queued)) {
+			queued_raw_move->movement += incoming_raw_move->movement;
+			return true;
+		}
+	}
+	else if (std::holds_alternative<event::SizeChange>(incoming) && std::holds_alternative<event::SizeChange>(queued)) {
+		queued = incoming;
+		return true;
+	}
+	return false;
+}
+
+static_assert(std::is_trivially_copyable_v<Event>, "Events are copied between threads and must not allocate.");
+static_assert(sizeof(Event) <= 32, "Events are copied between threads and should stay small.");
+
+[[nodiscard]]
+inline EventTime get_timestamp(Event const& event) {
+	return std::visit([](auto const& alternative) { return alternative.timestamp; }, event);
+}
+
+/*
+	Returns the name of the type of an event, for example "MouseMove".
+*/
+[[nodiscard]]
+constexpr std::string_view get_event_name(Event const& event) {
+	constexpr auto names = std::array<std::string_view, std::variant_size_v<Event>>{
+		"MouseMove", "MouseLeave", "MouseScroll", "MouseDown", "MouseUp", "KeyDown", "KeyUp", "CharacterInput",
+		"FocusGain", "FocusLose", "SizeChange", "StateChange", "Closed", "DpiChange", "RawMouseMove",
+	};
+	return event.valueless_by_exception() ? std::string_view{} : names[event.index()];
+}
+
+/*
+	Records a trace point for an event if tracing is on, see tracing::set_recorder.
+*/
+inline void trace_event(tracing::Point const point, Event const& event) {
+	if (auto const recorder = tracing::get_recorder()) {
+		auto const timestamp = get_timestamp(event);
+		recorder->record(point, get_event_name(event), 
+			timestamp == EventTime{} ? std::nullopt : std::optional{timestamp});
+	}
+}
+
 //------------------------------
 
 class Window;
@@ -257,13 +383,15 @@ struct Parameters {
 	StyleFlags style{StyleFlags::Default};
 	State state{State::Restored};
 	Window* parent{};
+	bool collect_event_statistics{};
 };
 
 //------------------------------
 
 /*
 	A Window creates a new window and automatically runs an event loop in a separate thread to keep it responsive and prevent blocking behavior.
-	Events are safely sent to the thread of the Window class and can be retrieved using await_event and take_event.
+	Events are safely sent to the thread of the Window class and can be retrieved using await_event and take_event,
+	or awaited from a coroutine using next_event.
 	If you don't call await_event or take_event regularly, the properties that can be retrieved using the accessor methods of this class will not be 
 	updated. The window would still be responsive however.
 
@@ -315,8 +443,53 @@ public:
 	[[nodiscard]]
 	Event await_event();
 
+	/*
+		Returns the next event if there is one, without waiting.
+	*/
 	[[nodiscard]]
 	std::optional<Event> take_event();
+
+	/*
+		Waits for the next event until a deadline, for example the time the next frame has to be drawn.
+		Returns std::nullopt if there was no event before the deadline.
+	*/
+	[[nodiscard]]
+	std::optional<Event> await_event_until(std::chrono::steady_clock::time_point deadline);
+	/*
+		Waits for the next event for at most the given duration.
+		Returns std::nullopt if there was no event in time.
+	*/
+	template<class Representation_, class Period_>
+	[[nodiscard]]
+	std::optional<Event> await_event_for(std::chrono::duration<Representation_, Period_> const timeout) {
+		return await_event_until(std::chrono::steady_clock::now() 
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+	}
+
+	/*
+		Returns a task that waits for the next event without blocking the thread:
+			auto const event = co_await window.next_event();
+		The awaiting coroutine is resumed on the concurrency::EventLoop that runs it, 
+		and std::logic_error is thrown if it is not running on one.
+		Only one coroutine can wait for the events of a window at a time, and the window must outlive the task.
+	*/
+	[[nodiscard]]
+	concurrency::Task<Event> next_event();
+
+	/*
+		Moves all events that are currently available to the end of a vector, without waiting.
+		This receives all of the events at once instead of one at a time.
+		Returns the number of events that were added.
+	*/
+	std::size_t take_events(std::vector<Event>&);
+
+	/*
+		Returns statistics about the events that have been sent from the window thread, such as how long they waited 
+		before they were taken, or std::nullopt unless the window was created with event statistics enabled.
+		See Builder::collect_event_statistics.
+	*/
+	[[nodiscard]]
+	std::optional<concurrency::ChannelStatistics> event_statistics() const;
 	
 	explicit Window(Parameters const& parameters);
 
@@ -388,6 +561,15 @@ public:
 		parameters_.parent = &parent;
 		return std::move(*this);
 	}
+	/*
+		Makes the window collect statistics about its event queue, see Window::event_statistics.
+	*/
+	[[nodiscard]]
+	Builder&& collect_event_statistics() && 
+	{
+		parameters_.collect_event_statistics = true;
+		return std::move(*this);
+	}
 
 	Builder() = delete;
 	~Builder() = default;
@@ -416,22 +598,6 @@ inline Builder create(std::string_view const title) {
 
 namespace detail {
 
-template<class T>
-struct ListenerVariant;
-
-template<class ... Event_>
-struct ListenerVariant<std::variant<Event_...>> {
-	using type = std::variant<std::function<void(Event_ const&)>...>;
-};
-
-} // namespace detail
-
-using EventListener = detail::ListenerVariant<Event>::type;
-
-//------------------------------
-
-namespace detail {
-
 template<class T, class EventVariant_>
 struct IsEventListener;
 
@@ -456,9 +622,16 @@ public:
 		Notifies listeners of any events currently available from the window.
 	*/
 	void update(Window& window) {
-		while (auto const event = window.take_event()) {
-			send_event_(*event);
+		// A listener may call update again, for example to run a modal loop, so the buffer is not iterated in place.
+		auto events = std::exchange(event_buffer_, {});
+		window.take_events(events);
+
+		for (auto const& event : events) {
+			send_event_(event);
 		}
+
+		events.clear();
+		event_buffer_ = std::move(events);
 	}
 	/*
 		Waits for one event from the window and notifies any listeners.
@@ -466,6 +639,19 @@ public:
 	void update_wait(Window& window) {
 		send_event_(window.await_event());
 	}
+	/*
+		Waits for one event from the window until a deadline and notifies any listeners, 
+		and then notifies them of any other events that are available.
+		Returns whether there were any events before the deadline.
+	*/
+	bool update_wait_until(Window& window, std::chrono::steady_clock::time_point const deadline) {
+		if (auto const event = window.await_event_until(deadline)) {
+			send_event_(*event);
+			update(window);
+			return true;
+		}
+		return false;
+	}
 	/*
 		Blocks until the window has been closed, automatically notifying event listeners of new events from the window.
 	*/
@@ -477,43 +663,34 @@ public:
 
 	/*
 		Adds an event listener invocable to be notified when an event of the type of its parameter is available.
-		This overload takes any invocable that isn't a std::function instantiation.
+		Any number of listeners can be added for the same event type, and all of them are notified.
 	*/
 	template<IsEventListener Listener_>
+		requires VariantEventListeners<Event>::is_listener<std::remove_cvref_t<Listener_>>
 	EventManager& add_listener(Listener_&& listener) {
-		listeners_.emplace_back(std::function{std::forward<Listener_>(listener)});
+		listeners_.add(std::forward<Listener_>(listener));
 		return *this;
 	}
 
 	/*
-		Adds an event listener invocable to be notified when an event of the type of its parameter is available.
-		This overload only takes std::function instantiations.
+		Returns the listeners of one event type, for example to remove a listener.
 	*/
-	template<IsEventListener Listener_> 
-		requires std::constructible_from<EventListener, Listener_>
-	EventManager& add_listener(Listener_&& listener) {
-		listeners_.emplace_back(std::forward<Listener_>(listener));
-		return *this;
+	template<class Event_>
+	[[nodiscard]]
+	EventListeners<void(Event_ const&)>& listeners() {
+		return listeners_.listeners<Event_>();
 	}
 
 private:
-	void send_event_(Event const& event_variant)
-	{
-		auto listener = std::ranges::find_if(listeners_, [&](auto const& listener) {
-			return listener.index() == event_variant.index();
-		});
-		if (listener != listeners_.end()) 
-		{
-			std::visit([]<class Listener_, class Event_>
-				(Listener_& listener, Event_ const& event) {
-					if constexpr (std::same_as<Listener_, std::function<void(Event_ const&)>>) {
-						listener(event);
-					}
-				}, *listener, event_variant);
-		}
+	void send_event_(Event const& event) {
+		listeners_(event);
+		trace_event(tracing::Point::EventDispatched, event);
 	}
 
-	std::vector<EventListener> listeners_;
+	VariantEventListeners<Event> listeners_;
+
+	// Reused by update so that receiving events does not allocate.
+	std::vector<Event> event_buffer_;
 };
 
 } // namespace avo::window
@@ -1,9 +1,12 @@
 // Included exactly once.
 
 #include "avo/concurrency.hpp"
+#include "avo/unicode.hpp"
+#include "avo/util/static_map.hpp"
 #include "avo/util/unique_handle.hpp"
 #include "avo/window.hpp"
 
+#include <bitset>
 #include <thread>
 
 //------------------------------
@@ -12,6 +15,10 @@
 #include <X11/keysym.h>
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
+#include <X11/XKBlib.h>
+#ifdef AVO_USE_XINPUT2
+#	include <X11/extensions/XInput2.h>
+#endif
 #include <GL/glx.h>
 #include <GL/glxext.h>
 #include <GL/gl.h>
@@ -377,10 +384,249 @@ void set_window_state(::Display* const server, ::Window const window,
 	XSendEvent(server, window, false, SubstructureNotifyMask, &event);
 }
 
+//------------------------------
+
+constexpr auto native_key_map = [] {
+	using enum KeyboardKey;
+	return util::StaticMap<::KeySym, KeyboardKey, 120>{
+		{XK_Menu, Menu},
+		{XK_BackSpace, Backspace},
+		{XK_Clear, Clear},
+		{XK_Tab, Tab},
+		{XK_Return, Enter},
+		{XK_KP_Enter, Enter},
+		{XK_Shift_L, Shift},
+		{XK_Shift_R, Shift},
+		{XK_Control_L, Control},
+		{XK_Control_R, Control},
+		{XK_Super_L, Super},
+		{XK_Super_R, Super},
+		{XK_Alt_L, Alt},
+		{XK_Alt_R, Alt},
+		{XK_Pause, Pause},
+		{XK_Caps_Lock, CapsLock},
+		{XK_Escape, Escape},
+		{XK_space, Spacebar},
+		{XK_Prior, PageUp},
+		{XK_Next, PageDown},
+		{XK_End, End},
+		{XK_Home, Home},
+		{XK_Left, Left},
+		{XK_Right, Right},
+		{XK_Up, Up},
+		{XK_Down, Down},
+		{XK_Print, PrintScreen},
+		{XK_Insert, Insert},
+		{XK_Delete, Delete},
+		{XK_Help, Help},
+		{XK_KP_0, Numpad0},
+		{XK_KP_1, Numpad1},
+		{XK_KP_2, Numpad2},
+		{XK_KP_3, Numpad3},
+		{XK_KP_4, Numpad4},
+		{XK_KP_5, Numpad5},
+		{XK_KP_6, Numpad6},
+		{XK_KP_7, Numpad7},
+		{XK_KP_8, Numpad8},
+		{XK_KP_9, Numpad9},
+		{XK_KP_Add, Add},
+		{XK_KP_Subtract, Subtract},
+		{XK_KP_Multiply, Multiply},
+		{XK_KP_Divide, Divide},
+		{XK_KP_Decimal, Decimal},
+		{XK_KP_Separator, Separator},
+		{XK_F1, F1},
+		{XK_F2, F2},
+		{XK_F3, F3},
+		{XK_F4, F4},
+		{XK_F5, F5},
+		{XK_F6, F6},
+		{XK_F7, F7},
+		{XK_F8, F8},
+		{XK_F9, F9},
+		{XK_F10, F10},
+		{XK_F11, F11},
+		{XK_F12, F12},
+		{XK_F13, F13},
+		{XK_F14, F14},
+		{XK_F15, F15},
+		{XK_F16, F16},
+		{XK_F17, F17},
+		{XK_F18, F18},
+		{XK_F19, F19},
+		{XK_F20, F20},
+		{XK_F21, F21},
+		{XK_F22, F22},
+		{XK_F23, F23},
+		{XK_F24, F24},
+		{XK_Num_Lock, NumLock},
+		{XK_0, Number0},
+		{XK_1, Number1},
+		{XK_2, Number2},
+		{XK_3, Number3},
+		{XK_4, Number4},
+		{XK_5, Number5},
+		{XK_6, Number6},
+		{XK_7, Number7},
+		{XK_8, Number8},
+		{XK_9, Number9},
+		{XK_a, A},
+		{XK_b, B},
+		{XK_c, C},
+		{XK_d, D},
+		{XK_e, E},
+		{XK_f, F},
+		{XK_g, G},
+		{XK_h, H},
+		{XK_i, I},
+		{XK_j, J},
+		{XK_k, K},
+		{XK_l, L},
+		{XK_m, M},
+		{XK_n, N},
+		{XK_o, O},
+		{XK_p, P},
+		{XK_q, Q},
+		{XK_r, R},
+		{XK_s, S},
+		{XK_t, T},
+		{XK_u, U},
+		{XK_v, V},
+		{XK_w, W},
+		{XK_x, X},
+		{XK_y, Y},
+		{XK_z, Z},
+		{XK_comma, Comma},
+		{XK_period, Period},
+		{XK_plus, Plus},
+		{XK_equal, Plus},
+		{XK_minus, Minus},
+		{XK_semicolon, Regional1},
+		{XK_slash, Regional2},
+		{XK_grave, Regional3},
+		{XK_bracketleft, Regional4},
+		{XK_backslash, Regional5},
+		{XK_bracketright, Regional6},
+		{XK_apostrophe, Regional7},
+		{XK_less, Regional8},
+	};
+}();
+
+/*
+	Returns the key symbol that identifies the physical key of a key event, 
+	regardless of modifiers except that the keypad is read as digits.
+*/
+[[nodiscard]]
+::KeySym get_key_symbol(::XKeyEvent& event) 
+{
+	if (auto const keypad_symbol = ::XLookupKeysym(&event, 1); IsKeypadKey(keypad_symbol)) {
+		return keypad_symbol;
+	}
+	return ::XLookupKeysym(&event, 0);
+}
+
+[[nodiscard]]
+KeyboardKey get_key(::XKeyEvent& event) 
+{
+	return native_key_map.find_or(get_key_symbol(event), KeyboardKey::None);
+}
+
+[[nodiscard]]
+MouseButton get_mouse_button(unsigned int const button) 
+{
+	switch (button) {
+		case Button1: return MouseButton::Left;
+		case Button2: return MouseButton::Middle;
+		case Button3: return MouseButton::Right;
+		case 8: return MouseButton::X0;
+		case 9: return MouseButton::X1;
+	}
+	return MouseButton::None;
+}
+
+/*
+	X11 has no concept of double clicks, so clicks are compared with the previous one.
+*/
+class DoubleClickDetector {
+public:
+	static constexpr auto max_interval = ::Time{500};
+	static constexpr auto max_distance = Pixels{4};
+
+	/*
+		Returns whether a button press is the second click of a double click.
+	*/
+	[[nodiscard]]
+	bool press(MouseButton const button, ::Time const time, math::Point<Pixels> const position) 
+	{
+		auto const is_double_click = button == last_button_ && time - last_time_ <= max_interval && 
+			std::abs(position.x - last_position_.x) <= max_distance && 
+			std::abs(position.y - last_position_.y) <= max_distance;
+
+		// A third click starts a new double click instead of completing another one.
+		last_button_ = is_double_click ? MouseButton::None : button;
+		last_time_ = time;
+		last_position_ = position;
+
+		return is_double_click;
+	}
+
+private:
+	MouseButton last_button_{MouseButton::None};
+	::Time last_time_{};
+	math::Point<Pixels> last_position_;
+};
+
+/*
+	Maps X server timestamps, which are milliseconds on a 32-bit clock with an unknown epoch, to steady_clock.
+	The offset between the clocks is estimated as the smallest difference seen between the time an event was 
+	received and its server time, since events can only be delayed and never arrive early.
+*/
+class ServerTimeConverter {
+public:
+	using Clock = tracing::Clock;
+
+	[[nodiscard]]
+	Clock::time_point to_steady_clock(::Time const server_time) 
+	{
+		auto const now = Clock::now();
+
+		// Server time wraps around after about 49.7 days.
+		auto const server_delta = static_cast<std::uint32_t>(server_time - last_server_time_);
+		if (not has_offset_ || server_delta < wraparound_threshold_) {
+			unwrapped_server_time_ += std::chrono::milliseconds{server_delta};
+		}
+		else {
+			// An event that is older than the previous one.
+			unwrapped_server_time_ -= std::chrono::milliseconds{static_cast<std::uint32_t>(last_server_time_ - server_time)};
+		}
+		last_server_time_ = static_cast<std::uint32_t>(server_time);
+
+		auto const offset = now - Clock::time_point{unwrapped_server_time_};
+		// The estimate is reset after large jumps, in case the server clock was changed.
+		if (not has_offset_ || offset < offset_ || offset - offset_ > max_drift_) {
+			offset_ = offset;
+			has_offset_ = true;
+		}
+		return std::min(Clock::time_point{unwrapped_server_time_} + offset_, now);
+	}
+
+private:
+	static constexpr auto wraparound_threshold_ = std::uint32_t{1} << 31;
+	static constexpr auto max_drift_ = std::chrono::seconds{10};
+
+	std::uint32_t last_server_time_{};
+	Clock::duration unwrapped_server_time_{};
+	Clock::duration offset_{};
+	bool has_offset_{};
+};
+
+//------------------------------
+
 class WindowThread {
 public:
 	static constexpr auto event_mask = ExposureMask | 
 		EnterWindowMask | LeaveWindowMask |
+		FocusChangeMask |
 		StructureNotifyMask | 
 		PointerMotionMask |
 		ButtonPressMask | ButtonReleaseMask |
@@ -408,7 +654,7 @@ public:
 		return handle_.get();
 	}
 
-	WindowThread(Parameters const& parameters, concurrency::Sender<Event> channel) :
+	WindowThread(Parameters const& parameters, concurrency::Sender<Event, EventQueue> channel) :
 		server_{::XOpenDisplay(nullptr)},
 		channel_{std::move(channel)},
 		thread_{&WindowThread::run_, this, parameters}
@@ -464,6 +710,9 @@ private:
 			XNFocusWindow, handle_.get(),
 			nullptr // Null terminator.
 		)};
+
+		// Without this, X sends a KeyRelease before every repeated KeyPress.
+		::XkbSetDetectableAutoRepeat(server_.get(), true, nullptr);
 	}
 
 	void setup_events_() {
@@ -477,9 +726,50 @@ private:
 		// Tell the window manager that we want it to send the event through WM_PROTOCOLS.
 		::XSetWMProtocols(server_.get(), handle_.get(), &window_close_event, 1);
 
+		select_high_resolution_motion_();
+
 		::XFlush(server_.get());
 	}
 
+	/*
+		Replaces core pointer motion events, which only have whole pixel positions, with XInput2 motion events
+		that have subpixel positions, and selects raw motion events from the root window for RawMouseMove,
+		if the X server supports XInput2.
+	*/
+	void select_high_resolution_motion_() {
+	#ifdef AVO_USE_XINPUT2
+		auto event_base = 0, error_base = 0;
+		if (not ::XQueryExtension(server_.get(), "XInputExtension", &xinput_opcode_, &event_base, &error_base)) {
+			return;
+		}
+		auto major_version = 2, minor_version = 0;
+		if (::XIQueryVersion(server_.get(), &major_version, &minor_version) != Success) {
+			return;
+		}
+
+		auto mask = std::array<unsigned char, XIMaskLen(XI_LASTEVENT)>{};
+		XISetMask(mask.data(), XI_Motion);
+
+		auto event_mask = ::XIEventMask{
+			.deviceid = XIAllMasterDevices,
+			.mask_len = static_cast<int>(mask.size()),
+			.mask = mask.data(),
+		};
+		::XISelectEvents(server_.get(), handle_.get(), &event_mask, 1);
+
+		// Raw events are only delivered to the root window.
+		auto raw_mask = std::array<unsigned char, XIMaskLen(XI_LASTEVENT)>{};
+		XISetMask(raw_mask.data(), XI_RawMotion);
+
+		auto raw_event_mask = ::XIEventMask{
+			.deviceid = XIAllMasterDevices,
+			.mask_len = static_cast<int>(raw_mask.size()),
+			.mask = raw_mask.data(),
+		};
+		::XISelectEvents(server_.get(), DefaultRootWindow(server_.get()), &raw_event_mask, 1);
+	#endif
+	}
+
 	void run_event_loop_() {
 		XInitThreads();
 
@@ -496,7 +786,7 @@ private:
 
 	//------------------------------
 	
-	void handle_event_(::XEvent const& event) {
+	void handle_event_(::XEvent& event) {
 		switch (event.type) {
 			case ConfigureNotify:
 				handle_configure_notify_(event);
@@ -504,27 +794,244 @@ private:
 			case ClientMessage:
 				handle_client_message_(event);
 				break;
+			case MotionNotify:
+				handle_mouse_move_(mouse_position_from_pixels_(event.xmotion.x, event.xmotion.y), event.xmotion.time);
+				break;
+			case EnterNotify:
+				mouse_position_ = mouse_position_from_pixels_(event.xcrossing.x, event.xcrossing.y);
+				break;
+			case LeaveNotify:
+				handle_mouse_leave_(event);
+				break;
+			case ButtonPress:
+				handle_mouse_down_(event);
+				break;
+			case ButtonRelease:
+				handle_mouse_up_(event);
+				break;
+			case KeyPress:
+				handle_key_down_(event);
+				break;
+			case KeyRelease:
+				handle_key_up_(event);
+				break;
+			case FocusIn:
+				handle_focus_change_(event, true);
+				break;
+			case FocusOut:
+				handle_focus_change_(event, false);
+				break;
+		#ifdef AVO_USE_XINPUT2
+			case GenericEvent:
+				handle_generic_event_(event);
+				break;
+		#endif
 		};
 	}
 
+	/*
+		Sends an event that happened at a time given by the X server.
+	*/
+	template<class Event_>
+	void send_event_(Event_ event, ::Time const server_time) {
+		event.timestamp = server_time_converter_.to_steady_clock(server_time);
+		channel_.send(event);
+	}
+	/*
+		Sends an event that does not come with a time from the X server, so it is timestamped now.
+	*/
+	template<class Event_>
+	void send_event_(Event_ event) {
+		event.timestamp = tracing::Clock::now();
+		channel_.send(event);
+	}
+
 	void handle_client_message_(::XEvent const& event) {
 		if (event.xclient.message_type == window_manager_client_message_type) {
 			// Sent from the window manager when the user has tried to close the window,
 			// it is up to us to decide whether to actually close and exit the application.
 			if (static_cast<::Atom>(event.xclient.data.l[0]) == window_close_event) {
 				is_running_ = false;
-				channel_.send(event::Closed{});
+				send_event_(event::Closed{});
 			}
 		}
 	}
 	void handle_configure_notify_(::XEvent const& event) {
-		channel_.send(event::SizeChange{
-			unit_converter_.pixels_to_dip(math::Size{event.xconfigure.width, event.xconfigure.height})
+		send_event_(event::SizeChange{
+			.size{unit_converter_.pixels_to_dip(math::Size{event.xconfigure.width, event.xconfigure.height})},
+			.timestamp{},
 		});
 	}
 
 	//------------------------------
 
+	/*
+		Converts a position in possibly fractional pixels to DIPs.
+	*/
+	[[nodiscard]]
+	math::Point<Dip> mouse_position_from_pixels_(double const x, double const y) const {
+		auto const dip_per_pixel = unit_converter_.pixels_to_dip(Pixels{1});
+		return math::Point{static_cast<Dip>(x)*dip_per_pixel, static_cast<Dip>(y)*dip_per_pixel};
+	}
+
+	void handle_mouse_move_(math::Point<Dip> const new_position, ::Time const time) {
+		if (new_position != mouse_position_) {
+			send_event_(event::MouseMove{
+				.position{new_position},
+				.movement{new_position - mouse_position_},
+				.timestamp{},
+			}, time);
+			mouse_position_ = new_position;
+		}
+	}
+	void handle_mouse_leave_(::XEvent const& event) {
+		auto const new_position = mouse_position_from_pixels_(event.xcrossing.x, event.xcrossing.y);
+		send_event_(event::MouseLeave{
+			.position{new_position},
+			.movement{new_position - mouse_position_},
+			.timestamp{},
+		}, event.xcrossing.time);
+		mouse_position_ = new_position;
+	}
+	void handle_mouse_down_(::XEvent const& event) {
+		auto const position = mouse_position_from_pixels_(event.xbutton.x, event.xbutton.y);
+
+		// Buttons 4 to 7 are the scroll wheel, and horizontal scrolling is not supported yet.
+		if (event.xbutton.button == Button4 || event.xbutton.button == Button5) {
+			send_event_(event::MouseScroll{
+				.position{position},
+				.scroll_delta{event.xbutton.button == Button4 ? 1.f : -1.f},
+				.timestamp{},
+			}, event.xbutton.time);
+			return;
+		}
+
+		if (auto const button = get_mouse_button(event.xbutton.button); button != MouseButton::None) {
+			send_event_(event::MouseDown{
+				.position{position},
+				.button{button},
+				.is_double_click{double_click_detector_.press(
+					button, event.xbutton.time, math::Point{event.xbutton.x, event.xbutton.y}
+				)},
+				.timestamp{},
+			}, event.xbutton.time);
+		}
+	}
+	void handle_mouse_up_(::XEvent const& event) {
+		if (auto const button = get_mouse_button(event.xbutton.button); button != MouseButton::None) {
+			send_event_(event::MouseUp{
+				.position{mouse_position_from_pixels_(event.xbutton.x, event.xbutton.y)},
+				.button{button},
+				.timestamp{},
+			}, event.xbutton.time);
+		}
+	}
+
+#ifdef AVO_USE_XINPUT2
+	void handle_generic_event_(::XEvent& event) {
+		auto& cookie = event.xcookie;
+		if (cookie.extension != xinput_opcode_ || not ::XGetEventData(server_.get(), &cookie)) {
+			return;
+		}
+		auto const free_data = util::Cleanup{[&]{ ::XFreeEventData(server_.get(), &cookie); }};
+
+		if (cookie.evtype == XI_Motion) {
+			auto const& device_event = *static_cast<::XIDeviceEvent const*>(cookie.data);
+			handle_mouse_move_(mouse_position_from_pixels_(device_event.event_x, device_event.event_y), device_event.time);
+		}
+		else if (cookie.evtype == XI_RawMotion) {
+			handle_raw_mouse_move_(*static_cast<::XIRawEvent const*>(cookie.data));
+		}
+	}
+	void handle_raw_mouse_move_(::XIRawEvent const& event) {
+		// Raw events come from the root window, so they would otherwise be sent for motion meant for other windows.
+		if (not has_focus_) {
+			return;
+		}
+
+		// The raw values are only given for the valuators in the mask, in order. Valuators 0 and 1 are the x and y axes.
+		auto movement = math::Vector2d<float>{};
+		auto value = event.raw_values;
+		for (auto const axis : {0, 1}) {
+			if (axis < event.valuators.mask_len*8 && XIMaskIsSet(event.valuators.mask, axis)) {
+				(axis == 0 ? movement.x : movement.y) = static_cast<float>(*value++);
+			}
+		}
+		if (movement) {
+			send_event_(event::RawMouseMove{.movement{movement}, .timestamp{}}, event.time);
+		}
+	}
+#endif
+
+	//------------------------------
+
+	void handle_key_down_(::XEvent& event) {
+		auto const key_code = static_cast<std::size_t>(event.xkey.keycode) % pressed_keys_.size();
+		auto const is_repeated = pressed_keys_.test(key_code);
+		pressed_keys_.set(key_code);
+
+		send_event_(event::KeyDown{
+			.key{get_key(event.xkey)},
+			.is_repeated{is_repeated},
+			.timestamp{},
+		}, event.xkey.time);
+
+		handle_character_input_(event, is_repeated);
+	}
+	void handle_key_up_(::XEvent& event) {
+		pressed_keys_.reset(static_cast<std::size_t>(event.xkey.keycode) % pressed_keys_.size());
+		send_event_(event::KeyUp{.key{get_key(event.xkey)}, .timestamp{}}, event.xkey.time);
+	}
+	/*
+		Sends the characters that a key press produced, if any, as one CharacterInput event per character.
+	*/
+	void handle_character_input_(::XEvent& event, bool const is_repeated) {
+		auto buffer = std::array<char, 64>{};
+		auto key_symbol = ::KeySym{};
+		auto status = Status{};
+
+		auto const length = ::Xutf8LookupString(
+			input_context_.get(), &event.xkey, 
+			buffer.data(), static_cast<int>(buffer.size()), 
+			&key_symbol, &status
+		);
+		if (status != XLookupChars && status != XLookupBoth) {
+			return;
+		}
+
+		auto characters = std::string_view{buffer.data(), static_cast<std::size_t>(length)};
+		while (not characters.empty()) {
+			auto const character_size = std::min(
+				static_cast<std::size_t>(std::max(unicode::code_point_count(characters.front()), 1)),
+				characters.size()
+			);
+			auto character_event = event::CharacterInput{.code_units{}, .size{}, .is_repeated{is_repeated}, .timestamp{}};
+			character_event.character(characters.substr(0, character_size));
+			send_event_(character_event, event.xkey.time);
+
+			characters.remove_prefix(character_size);
+		}
+	}
+
+	void handle_focus_change_(::XEvent const& event, bool const is_focused) {
+		// Focus changes caused by keyboard grabs, for example from the window manager, are not real focus changes.
+		if (event.xfocus.mode == NotifyGrab || event.xfocus.mode == NotifyUngrab) {
+			return;
+		}
+		has_focus_ = is_focused;
+		if (is_focused) {
+			::XSetICFocus(input_context_.get());
+			send_event_(event::FocusGain{});
+		}
+		else {
+			::XUnsetICFocus(input_context_.get());
+			pressed_keys_.reset();
+			send_event_(event::FocusLose{});
+		}
+	}
+
+	//------------------------------
+
 	DisplayHandle server_;
 	WindowHandle handle_;
 
@@ -535,9 +1042,19 @@ private:
 	InputMethodHandle input_method_;
 	InputContextHandle input_context_;
 
+	math::Point<Dip> mouse_position_;
+	DoubleClickDetector double_click_detector_;
+	ServerTimeConverter server_time_converter_;
+	// Indexed by key code, used to tell whether a key press is repeated.
+	std::bitset<256> pressed_keys_;
+	bool has_focus_{};
+#ifdef AVO_USE_XINPUT2
+	int xinput_opcode_{-1};
+#endif
+
 	std::atomic_flag window_created_flag_;
 
-	concurrency::Sender<Event> channel_;
+	concurrency::Sender<Event, EventQueue> channel_;
 	std::jthread thread_;
 };
 
@@ -623,56 +1140,92 @@ public:
 	Event await_event() 
 	{
 		auto event = channel_.receive();
+		update_state_(event);
+		return event;
+	}
 
-		if (auto const dpi_event = std::get_if<event::DpiChange>(&event))
-		{
-			dpi_ = dpi_event->dpi;
-		}
-		else if (auto const size_event = std::get_if<event::SizeChange>(&event))
-		{
-			size_ = size_event->size;
-		}
-		else if (std::holds_alternative<event::Closed>(event))
-		{
-			is_open_ = false;
+	[[nodiscard]]
+	std::optional<Event> take_event() 
+	{
+		auto event = channel_.try_receive();
+		if (event) {
+			update_state_(*event);
 		}
+		return event;
+	}
 
+	[[nodiscard]]
+	std::optional<Event> await_event_until(std::chrono::steady_clock::time_point const deadline) 
+	{
+		auto event = channel_.receive_until(deadline);
+		if (event) {
+			update_state_(*event);
+		}
 		return event;
 	}
 
 	[[nodiscard]]
-	std::optional<Event> take_event() 
+	concurrency::Task<Event> next_event() 
 	{
-		if (not channel_.was_queue_recently_empty()) {
-			return await_event();
+		auto event = co_await channel_.next();
+		update_state_(event);
+		co_return event;
+	}
+
+	std::size_t take_events(std::vector<Event>& events) 
+	{
+		auto const first_new = events.size();
+		channel_.receive_all(std::back_inserter(events));
+		
+		for (auto const& event : std::span{events}.subspan(first_new)) {
+			update_state_(event);
 		}
-		return std::nullopt;
+		return events.size() - first_new;
 	}
 
-	static constexpr auto max_queue_size = std::size_t{128};
+	[[nodiscard]]
+	std::optional<concurrency::ChannelStatistics> event_statistics() const 
+	{
+		return channel_.statistics();
+	}
 
-	Implementation(
-		Parameters const& parameters, 
-		concurrency::Channel<Event> channel = concurrency::create_channel<Event>(max_queue_size)
-	) :
+	explicit Implementation(Parameters const& parameters) :
+		Implementation{parameters, create_event_channel(parameters.collect_event_statistics)}
+	{}
+	Implementation(Parameters const& parameters, concurrency::Channel<Event, EventQueue> channel) :
 		size_{parameters.size},
 		channel_{std::move(channel.receiver)},
 		window_thread_{x11::WindowThread{parameters, std::move(channel.sender)}}
 	{
 		window_thread_.wait_until_window_created();
-
 	}
 
-
 private:
-	
+	void update_state_(Event const& event) 
+	{
+		trace_event(tracing::Point::EventReceived, event);
+
+		if (auto const dpi_event = std::get_if<event::DpiChange>(&event))
+		{
+			dpi_ = dpi_event->dpi;
+		}
+		else if (auto const size_event = std::get_if<event::SizeChange>(&event))
+		{
+			size_ = size_event->size;
+		}
+		else if (std::holds_alternative<event::Closed>(event))
+		{
+			is_open_ = false;
+		}
+	}
+
 	bool is_fullscreen_{};
 	math::Size<Dip> size_;
 	bool is_open_{true};
 
 	float dpi_{ScreenUnitConverter::normal_dpi};
 
-	concurrency::Receiver<Event> channel_;
+	concurrency::Receiver<Event, EventQueue> channel_;
 	x11::WindowThread window_thread_;
 };
 
@@ -1,3 +1,32 @@
+#include <avo/concurrency.hpp>
+#include <avo/window.hpp>
+
+namespace avo::window {
+
+/*
+	Events are passed from the window thread to the thread that owns the Window.
+	Exactly one thread pushes and one thread takes, so a lock-free ring buffer is used.
+	Consecutive mouse movements and size changes are merged so that a slow frame only loses stale motion.
+	The window thread never waits for the owning thread, which may itself be waiting for the window thread:
+	if the queue is full and an event cannot be merged, the queue grows past its maximum size, so no event is lost.
+*/
+using EventQueue = concurrency::SpscMessageQueue<Event>;
+
+/*
+	Creates the channel that the window thread of a platform backend sends events through.
+*/
+[[nodiscard]]
+concurrency::Channel<Event, EventQueue> create_event_channel(bool const collect_statistics) {
+	constexpr auto max_queue_size = std::size_t{128};
+	return concurrency::create_channel<Event, concurrency::SpscMessageQueue>(
+		max_queue_size, concurrency::OverflowPolicy::CoalesceOrGrow, &merge_events, collect_statistics
+	);
+}
+
+} // namespace avo::window
+
+//------------------------------
+
 #ifdef __GNUG__
 #	pragma GCC diagnostic push
 // GCC doesn't know that these headers will only ever be included in this translation unit.
@@ -88,6 +117,22 @@ std::optional<Event> Window::take_event() {
 	return implementation_->take_event();
 }
 
+std::optional<Event> Window::await_event_until(std::chrono::steady_clock::time_point const deadline) {
+	return implementation_->await_event_until(deadline);
+}
+
+concurrency::Task<Event> Window::next_event() {
+	return implementation_->next_event();
+}
+
+std::size_t Window::take_events(std::vector<Event>& events) {
+	return implementation_->take_events(events);
+}
+
+std::optional<concurrency::ChannelStatistics> Window::event_statistics() const {
+	return implementation_->event_statistics();
+}
+
 Window::Window(Parameters const& parameters) :
 	implementation_{std::make_unique<Implementation>(parameters)}
 {}
@@ -446,7 +446,7 @@ public:
 		return unit_converter_.pixels_to_dip(min_max_size_.load());
 	}
 
-	WindowThread(Parameters const& parameters, concurrency::Sender<Event> channel) :
+	WindowThread(Parameters const& parameters, concurrency::Sender<Event, EventQueue> channel) :
 		channel_{std::move(channel)},
 		thread_{&WindowThread::run_, this, parameters}
 	{}
@@ -608,7 +608,7 @@ private:
 	}
 	::LRESULT handle_dpi_change_(::WPARAM const w_data, ::LPARAM const l_data)
 	{
-		channel_.send(event::DpiChange{.dpi{static_cast<float>(HIWORD(w_data))}});
+		channel_.send(event::DpiChange{.dpi{static_cast<float>(HIWORD(w_data))}, .timestamp{}});
 
 		auto const new_rectangle = reinterpret_cast<::RECT const*>(l_data);
 		::SetWindowPos(
@@ -641,7 +641,8 @@ private:
 		{
 			channel_.send(event::MouseMove{
 				.position{unit_converter_.pixels_to_dip(new_position)},
-				.movement{unit_converter_.pixels_to_dip(new_position - mouse_position_)}
+				.movement{unit_converter_.pixels_to_dip(new_position - mouse_position_)},
+				.timestamp{},
 			});
 
 			mouse_position_ = new_position;
@@ -653,7 +654,8 @@ private:
 	{
 		channel_.send(event::MouseScroll{
 			.position{unit_converter_.pixels_to_dip(mouse_position_)},
-			.scroll_delta{GET_WHEEL_DELTA_WPARAM(w_data)/120.f}
+			.scroll_delta{GET_WHEEL_DELTA_WPARAM(w_data)/120.f},
+			.timestamp{},
 		});
 
 		return {};
@@ -667,7 +669,8 @@ private:
 
 		channel_.send(event::MouseLeave{
 			.position{unit_converter_.pixels_to_dip(new_position)},
-			.movement{unit_converter_.pixels_to_dip(new_position - mouse_position_)}
+			.movement{unit_converter_.pixels_to_dip(new_position - mouse_position_)},
+			.timestamp{},
 		});
 		
 		return {};
@@ -677,7 +680,8 @@ private:
 		channel_.send(event::MouseDown{
 			.position{unit_converter_.pixels_to_dip(math::Point{GET_X_LPARAM(l_data), GET_Y_LPARAM(l_data)})},
 			.button{button},
-			.is_double_click{is_double_click}
+			.is_double_click{is_double_click},
+			.timestamp{},
 		});
 		return {};
 	}
@@ -686,6 +690,7 @@ private:
 		channel_.send(event::MouseUp{
 			.position{unit_converter_.pixels_to_dip(math::Point{GET_X_LPARAM(l_data), GET_Y_LPARAM(l_data)})},
 			.button{button},
+			.timestamp{},
 		});
 		return {};
 	}
@@ -699,10 +704,9 @@ private:
 		auto const length = unicode::utf16_to_utf8(reinterpret_cast<char16_t const*>(&w_data), character);
 
 		if (length && *length) {
-			channel_.send(event::CharacterInput{
-				.character{character.data(), *length},
-				.is_repeated{get_is_key_repeated(l_data)}
-			});
+			auto event = event::CharacterInput{.code_units{}, .size{}, .is_repeated{get_is_key_repeated(l_data)}, .timestamp{}};
+			event.character({character.data(), *length});
+			channel_.send(event);
 		}
 
 		return {};
@@ -711,13 +715,14 @@ private:
 	{
 		channel_.send(event::KeyDown{
 			.key{native_key_map.find_or(static_cast<int>(w_data), KeyboardKey::None)},
-			.is_repeated{get_is_key_repeated(l_data)}
+			.is_repeated{get_is_key_repeated(l_data)},
+			.timestamp{},
 		});
 		return {};
 	}
 	::LRESULT handle_key_up_(::WPARAM const w_data)
 	{
-		channel_.send(event::KeyUp{native_key_map.find_or(static_cast<int>(w_data), KeyboardKey::None)});
+		channel_.send(event::KeyUp{.key{native_key_map.find_or(static_cast<int>(w_data), KeyboardKey::None)}, .timestamp{}});
 		return {};
 	}
 
@@ -726,22 +731,23 @@ private:
 		if (w_data == SIZE_MINIMIZED)
 		{
 			state_ = State::Minimized;
-			channel_.send(event::StateChange{state_});
+			channel_.send(event::StateChange{.state{state_}, .timestamp{}});
 		}
 		else {
 			if (w_data == SIZE_MAXIMIZED) 
 			{
 				state_ = State::Maximized;
-				channel_.send(event::StateChange{state_});
+				channel_.send(event::StateChange{.state{state_}, .timestamp{}});
 			}
 			else if (w_data == SIZE_RESTORED && state_ != State::Restored)
 			{
 				state_ = State::Restored;
-				channel_.send(event::StateChange{state_});
+				channel_.send(event::StateChange{.state{state_}, .timestamp{}});
 			}
 
 			channel_.send(event::SizeChange{
-				unit_converter_.pixels_to_dip(math::Size{static_cast<int>(LOWORD(l_data)), static_cast<int>(HIWORD(l_data))})
+				.size{unit_converter_.pixels_to_dip(math::Size{static_cast<int>(LOWORD(l_data)), static_cast<int>(HIWORD(l_data))})},
+				.timestamp{},
 			});
 		}
 
@@ -841,7 +847,7 @@ private:
 	::HWND handle_{};
 	std::atomic_flag window_created_flag_{};
 
-	concurrency::Sender<Event> channel_;
+	concurrency::Sender<Event, EventQueue> channel_;
 	std::jthread thread_;
 };
 
@@ -948,38 +954,59 @@ public:
 	Event await_event() 
 	{
 		auto event = channel_.receive();
+		update_state_(event);
+		return event;
+	}
 
-		if (auto const dpi_event = std::get_if<event::DpiChange>(&event))
-		{
-			dpi_ = dpi_event->dpi;
-		}
-		else if (auto const size_event = std::get_if<event::SizeChange>(&event))
-		{
-			size_ = size_event->size;
-		}
-		else if (std::holds_alternative<event::Closed>(event))
-		{
-			is_open_ = false;
+	[[nodiscard]]
+	std::optional<Event> take_event() 
+	{
+		auto event = channel_.try_receive();
+		if (event) {
+			update_state_(*event);
 		}
+		return event;
+	}
 
+	[[nodiscard]]
+	std::optional<Event> await_event_until(std::chrono::steady_clock::time_point const deadline) 
+	{
+		auto event = channel_.receive_until(deadline);
+		if (event) {
+			update_state_(*event);
+		}
 		return event;
 	}
 
 	[[nodiscard]]
-	std::optional<Event> take_event() 
+	concurrency::Task<Event> next_event() 
+	{
+		auto event = co_await channel_.next();
+		update_state_(event);
+		co_return event;
+	}
+
+	std::size_t take_events(std::vector<Event>& events) 
 	{
-		if (not channel_.was_queue_recently_empty()) {
-			return await_event();
+		auto const first_new = events.size();
+		channel_.receive_all(std::back_inserter(events));
+		
+		for (auto const& event : std::span{events}.subspan(first_new)) {
+			update_state_(event);
 		}
-		return std::nullopt;
+		return events.size() - first_new;
 	}
 
-	static constexpr auto max_queue_size = std::size_t{128};
+	[[nodiscard]]
+	std::optional<concurrency::ChannelStatistics> event_statistics() const 
+	{
+		return channel_.statistics();
+	}
 
-	Implementation(
-		Parameters const& parameters, 
-		concurrency::Channel<Event> channel = concurrency::create_channel<Event>(max_queue_size)
-	) : 
+	explicit Implementation(Parameters const& parameters) :
+		Implementation{parameters, create_event_channel(parameters.collect_event_statistics)}
+	{}
+	Implementation(Parameters const& parameters, concurrency::Channel<Event, EventQueue> channel) : 
 		size_{parameters.size},
 		channel_{std::move(channel.receiver)},
 		window_thread_{win::WindowThread{parameters, std::move(channel.sender)}}
@@ -989,12 +1016,30 @@ public:
 	}
 
 private:
+	void update_state_(Event const& event) 
+	{
+		trace_event(tracing::Point::EventReceived, event);
+
+		if (auto const dpi_event = std::get_if<event::DpiChange>(&event))
+		{
+			dpi_ = dpi_event->dpi;
+		}
+		else if (auto const size_event = std::get_if<event::SizeChange>(&event))
+		{
+			size_ = size_event->size;
+		}
+		else if (std::holds_alternative<event::Closed>(event))
+		{
+			is_open_ = false;
+		}
+	}
+
 	float dpi_{ScreenUnitConverter::normal_dpi};
 	math::Size<Dip> size_;
 	bool is_open_{true};
 	win::FullscreenToggle fullscreen_toggle_;
 
-	concurrency::Receiver<Event> channel_;
+	concurrency::Receiver<Event, EventQueue> channel_;
 	win::WindowThread window_thread_;
 };
 
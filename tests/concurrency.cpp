@@ -1,8 +1,11 @@
 #include <avo/concurrency.hpp>
+#include <avo/node.hpp>
 #include <avo/util/int_range.hpp>
 
 #include <catch.hpp>
 
+#include <chrono>
+#include <functional>
 #include <thread>
 
 constexpr auto messages = std::array{5, 184, 9, -4, 77, 1};
@@ -88,3 +91,809 @@ TEST_CASE("Message channel, send waiting and receive waiting") {
 	}
 }
 
+
+TEST_CASE("Lock-free SPSC message channel, capacity and order") {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, avo::concurrency::SpscMessageQueue>(5);
+
+	REQUIRE(receiver.was_queue_recently_empty());
+
+	// The capacity is rounded up to a power of two.
+	for (auto const i : avo::util::Range{8}) {
+		REQUIRE(sender.send(i));
+	}
+	REQUIRE(not sender.send(8));
+	REQUIRE(sender.recent_queue_size() == 8);
+
+	REQUIRE(receiver.receive_peek() == 0);
+	receiver.remove_next();
+	
+	for (auto const i : avo::util::Range{1, 7}) {
+		REQUIRE(receiver.receive() == i);
+	}
+	REQUIRE(receiver.was_queue_recently_empty());
+}
+
+TEST_CASE("Lock-free SPSC message channel, wrapping around between threads") {
+	auto [sender, receiver] = avo::concurrency::create_channel<std::unique_ptr<int>, avo::concurrency::SpscMessageQueue>(4);
+
+	constexpr auto message_count = 10'000;
+
+	auto const thread = std::jthread{[sender = std::move(sender)]() mutable {
+		for (auto const i : avo::util::Range{message_count}) {
+			auto message = std::make_unique<int>(i);
+			while (not sender.send(std::move(message))) {
+				std::this_thread::yield();
+			}
+		}
+		// These are destroyed together with the queue.
+		sender.send(std::make_unique<int>(-1));
+		sender.send(std::make_unique<int>(-2));
+	}};
+
+	auto is_in_order = true;
+	for (auto const i : avo::util::Range{message_count}) {
+		is_in_order = is_in_order && *receiver.receive() == i;
+	}
+	REQUIRE(is_in_order);
+}
+
+TEST_CASE("Message channel, send and receive in batches") {
+	auto [sender, receiver] = avo::concurrency::create_channel<int>(4);
+
+	REQUIRE(sender.send_batch(messages) == 4);
+	REQUIRE(receiver.recent_queue_size() == 4);
+
+	auto received = std::vector<int>{};
+	receiver.receive_all(std::back_inserter(received));
+	REQUIRE(std::ranges::equal(received, std::span{messages}.first(4)));
+	REQUIRE(receiver.was_queue_recently_empty());
+
+	REQUIRE(sender.send_batch(std::span{messages}.subspan(4)) == 2);
+	REQUIRE(std::ranges::equal(receiver.drain(), std::span{messages}.subspan(4)));
+	REQUIRE(receiver.drain().empty());
+}
+
+TEST_CASE("Lock-free SPSC message channel, send and receive in batches between threads") {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, avo::concurrency::SpscMessageQueue>(8);
+
+	static constexpr auto message_count = 10'000;
+
+	auto const thread = std::jthread{[sender = std::move(sender)]() mutable {
+		for (auto first = 0; first < message_count;) {
+			first += static_cast<int>(sender.send_batch(std::views::iota(first, message_count)));
+		}
+	}};
+
+	auto received = std::vector<int>{};
+	while (received.size() < std::size_t{message_count}) {
+		receiver.receive_all(std::back_inserter(received));
+	}
+	REQUIRE(std::ranges::equal(received, std::views::iota(0, message_count)));
+}
+
+TEST_CASE("Lock-free MPMC message channel, capacity and order") {
+	using Channel = avo::concurrency::Channel<int, avo::concurrency::MpmcMessageQueue<int>>;
+	static_assert(std::copyable<decltype(Channel::sender)> && std::copyable<decltype(Channel::receiver)>);
+	static_assert(not std::copy_constructible<avo::concurrency::Sender<int, avo::concurrency::SpscMessageQueue<int>>>);
+
+	auto [sender, receiver] = avo::concurrency::create_mpmc_channel<int>(3);
+	REQUIRE(sender.send_batch(messages) == 4);
+	REQUIRE_FALSE(sender.send(1));
+
+	auto const other_receiver = receiver;
+	REQUIRE(other_receiver.recent_queue_size() == 4);
+
+	for (auto const message : std::span{messages}.first(4)) {
+		REQUIRE(receiver.receive() == message);
+	}
+	REQUIRE(receiver.was_queue_recently_empty());
+
+	REQUIRE(sender.send(messages[4]));
+	receiver.remove_next();
+	REQUIRE(receiver.drain().empty());
+}
+
+TEST_CASE("Lock-free MPMC message channel, distributing work between threads") {
+	auto [sender, receiver] = avo::concurrency::create_mpmc_channel<int>(16);
+
+	static constexpr auto thread_count = 4;
+	static constexpr auto messages_per_producer = 5'000;
+
+	auto totals = std::array<std::pair<int, long long>, thread_count>{};
+	{
+		auto consumers = std::vector<std::jthread>{};
+		for (auto& [count, sum] : totals) {
+			consumers.emplace_back([receiver, &count, &sum]() mutable {
+				for (auto message = receiver.receive(); message >= 0; message = receiver.receive()) {
+					++count;
+					sum += message;
+				}
+			});
+		}
+
+		{
+			auto producers = std::vector<std::jthread>{};
+			for (auto const producer : avo::util::Range{thread_count}) {
+				producers.emplace_back([sender, producer]() mutable {
+					for (auto const i : avo::util::Range{messages_per_producer}) {
+						while (not sender.send(producer*messages_per_producer + i)) {
+							std::this_thread::yield();
+						}
+					}
+				});
+			}
+		}
+
+		// One stop message for every consumer.
+		for (auto sent = 0; sent < thread_count;) {
+			if (sender.send(-1)) {
+				++sent;
+			}
+		}
+	}
+
+	auto total_count = 0;
+	auto total_sum = 0ll;
+	for (auto const& [count, sum] : totals) {
+		total_count += count;
+		total_sum += sum;
+	}
+
+	constexpr auto message_count = thread_count*messages_per_producer;
+	REQUIRE(total_count == message_count);
+	REQUIRE(total_sum == static_cast<long long>(message_count)*(message_count - 1)/2);
+}
+
+TEST_CASE("Work-stealing deque, taking and stealing from both ends") {
+	auto deque = avo::concurrency::WorkStealingDeque<int>{2};
+
+	for (auto const i : avo::util::Range{10}) {
+		deque.push(i);
+	}
+	REQUIRE(deque.recent_size() == 10);
+
+	REQUIRE(deque.take() == 9);
+	REQUIRE(deque.steal() == 0);
+	REQUIRE(deque.take() == 8);
+	REQUIRE(deque.steal() == 1);
+
+	auto rest = std::vector<int>{};
+	while (auto const item = deque.take()) {
+		rest.push_back(*item);
+	}
+	REQUIRE(std::ranges::equal(rest, (avo::util::Range<int, true>{7, 2})));
+	REQUIRE(deque.was_recently_empty());
+	REQUIRE_FALSE(deque.steal());
+}
+
+TEST_CASE("Thread pool, submitting tasks") {
+	auto pool = avo::concurrency::ThreadPool{3};
+	REQUIRE(pool.thread_count() == 3);
+
+	auto future = pool.submit([] { return 5; });
+	REQUIRE(future.get() == 5);
+
+	// Tasks that wait for tasks they submit themselves must not deadlock the pool.
+	auto fibonacci = std::function<int(int)>{};
+	fibonacci = [&](int const n) {
+		if (n < 2) {
+			return n;
+		}
+		auto first = pool.submit([&, n] { return fibonacci(n - 1); });
+		auto second = pool.submit([&, n] { return fibonacci(n - 2); });
+		return first.get() + second.get();
+	};
+	REQUIRE(pool.submit([&] { return fibonacci(15); }).get() == 610);
+
+	auto failing = pool.submit([] { throw std::runtime_error{"Failed."}; });
+	REQUIRE_THROWS_AS(failing.get(), std::runtime_error);
+}
+
+TEST_CASE("Thread pool, parallel for") {
+	auto pool = avo::concurrency::ThreadPool{4};
+
+	auto visit_counts = std::vector<std::atomic<int>>(1000);
+	pool.parallel_for(avo::util::indices(visit_counts), [&](std::size_t const index) {
+		visit_counts[index].fetch_add(1, std::memory_order::relaxed);
+	});
+	REQUIRE(std::ranges::all_of(visit_counts, [](auto const& count) { return count.load() == 1; }));
+
+	auto sum = std::atomic<int>{};
+	pool.parallel_for(avo::util::Range{-50, 50}, [&](int const value) { sum += value; }, 7);
+	REQUIRE(sum == 0);
+
+	pool.parallel_for(avo::util::Range{0}, [](int) { FAIL(); });
+
+	REQUIRE_THROWS_AS(
+		pool.parallel_for(avo::util::Range{100}, [](int const value) {
+			if (value == 42) {
+				throw std::runtime_error{"Failed."};
+			}
+		}, 1),
+		std::runtime_error
+	);
+}
+
+TEST_CASE("Thread pool, parallel traversal of node trees") {
+	auto pool = avo::concurrency::ThreadPool{4};
+
+	constexpr auto node_count = 3000;
+
+	// Wide near the root and deep further down.
+	auto root = avo::Node{avo::Id{1}};
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	for (auto const i : avo::util::Range{2, node_count}) {
+		auto& parent = i < 50 ? root : *nodes[static_cast<std::size_t>(i/3 - 1)];
+		nodes.push_back(std::make_unique<avo::Node>(parent, avo::Id{static_cast<avo::Id::value_type>(i)}));
+	}
+
+	auto is_visited = std::vector<std::atomic<bool>>(node_count + 1);
+	auto is_parent_visited_first = std::atomic<bool>{true};
+	pool.parallel_for_each_subtree(root, [&](avo::Node& node) {
+		if (node.parent() and not is_visited[node.parent()->id().value()].load()) {
+			is_parent_visited_first = false;
+		}
+		is_visited[node.id().value()] = true;
+	}, 16);
+	REQUIRE(is_parent_visited_first);
+	REQUIRE(std::all_of(is_visited.begin() + 1, is_visited.end(), [](auto const& visited) { return visited.load(); }));
+
+	// Concatenation is associative but not commutative, so the result only matches the order of a sequential traversal
+	// if the values of the subtrees are reduced in order.
+	auto const ids = pool.parallel_reduce_subtree(std::as_const(root), 
+		[](avo::Node const& node) { return std::vector{node.id().value()}; },
+		[](std::vector<avo::Id::value_type> left, std::vector<avo::Id::value_type> const& right) {
+			left.insert(left.end(), right.begin(), right.end());
+			return left;
+		}, 
+		8
+	);
+	REQUIRE(std::ranges::equal(ids, root | avo::util::flatten, {}, {}, [](avo::Node const& node) { return node.id().value(); }));
+
+	auto const sum = pool.parallel_reduce_subtree(root, [](avo::Node& node) { return node.id().value(); }, std::plus{});
+	REQUIRE(sum == node_count*(node_count + 1)/2);
+
+	REQUIRE_THROWS_AS(
+		pool.parallel_for_each_subtree(root, [](avo::Node const& node) {
+			if (node.id() == avo::Id{1000}) {
+				throw std::runtime_error{"Failed."};
+			}
+		}, 4),
+		std::runtime_error
+	);
+}
+
+namespace {
+
+avo::concurrency::Task<int> add_received(avo::concurrency::Receiver<int>& receiver, int const count) {
+	auto sum = 0;
+	for (auto i = 0; i < count; ++i) {
+		sum += co_await receiver.next();
+	}
+	co_return sum;
+}
+
+} // namespace
+
+TEST_CASE("Coroutine event loop, awaiting messages and tasks") {
+	auto [sender, receiver] = avo::concurrency::create_channel<int>();
+	auto loop = avo::concurrency::EventLoop{};
+
+	auto result = 0;
+	loop.spawn([](auto& receiver, int& result) -> avo::concurrency::Task<> {
+		result = co_await add_received(receiver, 3);
+	}(receiver, result));
+
+	REQUIRE(loop.run_pending() == 1);
+	REQUIRE(loop.task_count() == 1);
+
+	sender.send(1);
+	sender.send(2);
+	REQUIRE(loop.run_pending() == 1);
+	REQUIRE(loop.task_count() == 1);
+
+	sender.send(3);
+	REQUIRE(loop.run_pending() == 1);
+	REQUIRE(loop.task_count() == 0);
+	REQUIRE(result == 6);
+
+	loop.spawn([]() -> avo::concurrency::Task<> {
+		throw std::runtime_error{"Failed."};
+		co_return;
+	}());
+	REQUIRE_THROWS_AS(loop.run(), std::runtime_error);
+	REQUIRE(loop.task_count() == 0);
+}
+
+TEST_CASE("Coroutine awaiting a receiver outside of an event loop") {
+	auto [sender, receiver] = avo::concurrency::create_channel<int>();
+
+	auto const handle = add_received(receiver, 1).release();
+	handle.resume();
+	REQUIRE(handle.done());
+	REQUIRE_THROWS_AS(handle.promise().take_result(), std::logic_error);
+	handle.destroy();
+}
+
+TEST_CASE("Coroutine event loop, many coroutines waiting for messages from another thread") {
+	static constexpr auto coroutine_count = 1000;
+
+	using Channel = avo::concurrency::Channel<int, avo::concurrency::SpscMessageQueue<int>>;
+	auto channels = std::vector<Channel>{};
+	for (auto const i : avo::util::Range{coroutine_count}) {
+		static_cast<void>(i);
+		channels.push_back(avo::concurrency::create_channel<int, avo::concurrency::SpscMessageQueue>(2));
+	}
+
+	auto loop = avo::concurrency::EventLoop{};
+	auto received_sum = 0;
+	for (auto& channel : channels) {
+		loop.spawn([](auto& receiver, int& sum) -> avo::concurrency::Task<> {
+			sum += co_await receiver.next();
+			sum += co_await receiver.next();
+		}(channel.receiver, received_sum));
+	}
+	loop.run_pending();
+
+	auto const thread = std::jthread{[&channels] {
+		for (auto const i : avo::util::Range{coroutine_count}) {
+			channels[static_cast<std::size_t>(i)].sender.send(i);
+		}
+		for (auto const i : avo::util::Range{coroutine_count}) {
+			channels[static_cast<std::size_t>(i)].sender.send(1);
+		}
+	}};
+	loop.run();
+
+	REQUIRE(received_sum == coroutine_count*(coroutine_count - 1)/2 + coroutine_count);
+}
+
+namespace {
+
+template<template<class> class Queue_>
+void test_timed_receive() {
+	using namespace std::chrono_literals;
+
+	auto [sender, receiver] = avo::concurrency::create_channel<int, Queue_>(8);
+
+	REQUIRE_FALSE(receiver.try_receive());
+	sender.send(5);
+	REQUIRE(receiver.try_receive() == 5);
+	REQUIRE_FALSE(receiver.try_receive());
+
+	auto const start = std::chrono::steady_clock::now();
+	REQUIRE_FALSE(receiver.receive_for(20ms));
+	REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+
+	auto const thread = std::jthread{[&sender] {
+		std::this_thread::sleep_for(10ms);
+		sender.send(7);
+	}};
+	REQUIRE(receiver.receive_until(std::chrono::steady_clock::now() + 10s) == 7);
+}
+
+} // namespace
+
+TEST_CASE("Message channel, receiving without waiting and with deadlines") {
+	test_timed_receive<avo::concurrency::MessageQueue>();
+	test_timed_receive<avo::concurrency::SpscMessageQueue>();
+	test_timed_receive<avo::concurrency::MpmcMessageQueue>();
+}
+
+namespace {
+
+bool add_if_both_even(int& queued, int const& incoming) {
+	if (queued % 2 == 0 && incoming % 2 == 0) {
+		queued += incoming;
+		return true;
+	}
+	return false;
+}
+
+template<template<class> class Queue_>
+void test_coalescing() {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, Queue_>(
+		8, avo::concurrency::OverflowPolicy::Coalesce, &add_if_both_even
+	);
+	REQUIRE(sender.send_batch(std::array{2, 4, 1, 6, 8, 3, 5}) == 7);
+	REQUIRE(receiver.drain() == std::vector{6, 1, 14, 3, 5});
+
+	// The message that is being received is no longer merged with.
+	sender.send(2);
+	REQUIRE(receiver.receive() == 2);
+	sender.send(2);
+	REQUIRE(receiver.receive() == 2);
+}
+
+template<template<class> class Queue_>
+void test_growing() {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, Queue_>(
+		4, avo::concurrency::OverflowPolicy::CoalesceOrGrow, &add_if_both_even, true
+	);
+	// The queue grows for 9, 2 and 11, and 4 is merged into 2.
+	REQUIRE(sender.send_batch(std::array{1, 3, 5, 7, 9, 2, 4, 11}) == 8);
+	REQUIRE(receiver.drain() == std::vector{1, 3, 5, 7, 9, 6, 11});
+
+	auto const statistics = *receiver.statistics();
+	REQUIRE(statistics.pushed_count == 7);
+	REQUIRE(statistics.coalesced_count == 1);
+	REQUIRE(statistics.dropped_count == 0);
+	REQUIRE(statistics.rejected_count == 0);
+}
+
+} // namespace
+
+TEST_CASE("Message channel, overflow policies") {
+	using avo::concurrency::OverflowPolicy;
+
+	{
+		auto [sender, receiver] = avo::concurrency::create_channel<int>(3, OverflowPolicy::DropOldest);
+		REQUIRE(sender.send_batch(messages) == messages.size());
+		REQUIRE(std::ranges::equal(receiver.drain(), std::span{messages}.last(3)));
+	}
+	{
+		auto [sender, receiver] = avo::concurrency::create_mpmc_channel<int>(4, OverflowPolicy::DropOldest);
+		REQUIRE(sender.send_batch(messages) == messages.size());
+		REQUIRE(std::ranges::equal(receiver.drain(), std::span{messages}.last(4)));
+	}
+
+	test_coalescing<avo::concurrency::MessageQueue>();
+	test_coalescing<avo::concurrency::SpscMessageQueue>();
+
+	test_growing<avo::concurrency::MessageQueue>();
+	test_growing<avo::concurrency::SpscMessageQueue>();
+
+	{
+		auto [sender, receiver] = avo::concurrency::create_channel<int, avo::concurrency::SpscMessageQueue>(
+			2, OverflowPolicy::CoalesceOrGrow, &add_if_both_even
+		);
+		REQUIRE(sender.send_batch(std::array{1, 3, 2}) == 3);
+		REQUIRE(receiver.receive() == 1);
+		REQUIRE(receiver.receive() == 3);
+		// A peeked message that did not fit in the ring buffer is not merged with either.
+		REQUIRE(receiver.receive_peek() == 2);
+		sender.send(4);
+		REQUIRE(receiver.drain() == std::vector{2, 4});
+	}
+
+	REQUIRE_THROWS_AS(avo::concurrency::SpscMessageQueue<int>(4, OverflowPolicy::DropOldest), std::invalid_argument);
+	REQUIRE_THROWS_AS(avo::concurrency::MpmcMessageQueue<int>(4, OverflowPolicy::Coalesce), std::invalid_argument);
+	REQUIRE_THROWS_AS(avo::concurrency::MessageQueue<int>(4, OverflowPolicy::Coalesce), std::invalid_argument);
+	REQUIRE_THROWS_AS(avo::concurrency::MpmcMessageQueue<int>(4, OverflowPolicy::CoalesceOrGrow), std::invalid_argument);
+}
+
+namespace {
+
+template<template<class> class Queue_>
+void test_blocking_overflow(avo::concurrency::OverflowPolicy const policy) {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, Queue_>(2, policy, &add_if_both_even);
+
+	static constexpr auto message_count = 5'000;
+
+	auto const thread = std::jthread{[sender = std::move(sender)]() mutable {
+		for (auto const i : avo::util::Range{message_count}) {
+			// Odd numbers are never merged, so all of them have to arrive.
+			sender.send(i*2 + 1);
+			sender.send(2);
+			sender.send(2);
+		}
+		sender.send(-1);
+	}};
+
+	auto expected = 1;
+	auto is_in_order = true;
+	auto even_sum = 0;
+	for (auto message = receiver.receive(); message != -1; message = receiver.receive()) {
+		if (message % 2 == 0) {
+			even_sum += message;
+		}
+		else {
+			is_in_order = is_in_order && message == expected;
+			expected += 2;
+		}
+	}
+	REQUIRE(is_in_order);
+	REQUIRE(expected == message_count*2 + 1);
+	REQUIRE(even_sum == message_count*4);
+}
+
+} // namespace
+
+TEST_CASE("Message channel, blocking when full between threads") {
+	using avo::concurrency::OverflowPolicy;
+
+	test_blocking_overflow<avo::concurrency::MessageQueue>(OverflowPolicy::Block);
+	test_blocking_overflow<avo::concurrency::MessageQueue>(OverflowPolicy::Coalesce);
+	test_blocking_overflow<avo::concurrency::SpscMessageQueue>(OverflowPolicy::Block);
+	test_blocking_overflow<avo::concurrency::SpscMessageQueue>(OverflowPolicy::Coalesce);
+	test_blocking_overflow<avo::concurrency::MpmcMessageQueue>(OverflowPolicy::Block);
+}
+
+namespace {
+
+template<template<class> class Queue_>
+void test_growing_overflow(bool const is_receiving_after_sending) {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, Queue_>(
+		2, avo::concurrency::OverflowPolicy::CoalesceOrGrow, &add_if_both_even
+	);
+
+	static constexpr auto message_count = 5'000;
+
+	// The sender never waits for the receiver, so it finishes even if nothing has been received yet.
+	auto thread = std::jthread{[sender = std::move(sender)]() mutable {
+		for (auto const i : avo::util::Range{message_count}) {
+			// Odd numbers are never merged, so all of them have to arrive.
+			sender.send(i*2 + 1);
+			sender.send(2);
+			sender.send(2);
+		}
+		sender.send(-1);
+	}};
+	if (is_receiving_after_sending) {
+		thread.join();
+	}
+
+	auto expected = 1;
+	auto is_in_order = true;
+	auto even_sum = 0;
+	for (auto message = receiver.receive(); message != -1; message = receiver.receive()) {
+		if (message % 2 == 0) {
+			even_sum += message;
+		}
+		else {
+			is_in_order = is_in_order && message == expected;
+			expected += 2;
+		}
+	}
+	REQUIRE(is_in_order);
+	REQUIRE(expected == message_count*2 + 1);
+	REQUIRE(even_sum == message_count*4);
+}
+
+} // namespace
+
+TEST_CASE("Message channel, growing when full between threads") {
+	for (auto const is_receiving_after_sending : {false, true}) {
+		test_growing_overflow<avo::concurrency::MessageQueue>(is_receiving_after_sending);
+		test_growing_overflow<avo::concurrency::SpscMessageQueue>(is_receiving_after_sending);
+	}
+}
+
+namespace {
+
+template<template<class> class Queue_>
+void test_statistics(avo::concurrency::OverflowPolicy const policy) {
+	auto [sender, receiver] = avo::concurrency::create_channel<int, Queue_>(4, policy, &add_if_both_even, true);
+
+	REQUIRE(sender.send_batch(std::array{1, 3, 5, 7, 9, 11}) == 4);
+	std::this_thread::sleep_for(std::chrono::milliseconds{2});
+	REQUIRE(receiver.receive() == 1);
+	REQUIRE(receiver.drain().size() == 3);
+
+	auto const statistics = *receiver.statistics();
+	REQUIRE(statistics == *sender.statistics());
+	REQUIRE(statistics.pushed_count == 4);
+	REQUIRE(statistics.taken_count == 4);
+	REQUIRE(statistics.rejected_count == 1);
+	REQUIRE(statistics.dropped_count == 0);
+	REQUIRE(statistics.high_water_mark == 4);
+	// The first message waited for at least the sleep.
+	REQUIRE(statistics.latency_percentile(1.) >= std::chrono::milliseconds{2});
+	REQUIRE(statistics.latency_percentile(0.01) <= statistics.latency_percentile(1.));
+
+	// A receiver that is waiting when the message is sent has to be woken up. Whether it has started waiting by then
+	// is up to the scheduler, so this is repeated until it has. The sleep only makes that likely on the first attempt.
+	for (auto attempt_count = 1; receiver.statistics()->wake_up_count == 0; ++attempt_count) {
+		REQUIRE(attempt_count <= 1'000);
+
+		auto received = 0;
+		{
+			auto const thread = std::jthread{[&receiver, &received] {
+				received = receiver.receive();
+			}};
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+			sender.send(13);
+		}
+		REQUIRE(received == 13);
+	}
+}
+
+} // namespace
+
+TEST_CASE("Message channel, statistics") {
+	using avo::concurrency::OverflowPolicy;
+
+	test_statistics<avo::concurrency::MessageQueue>(OverflowPolicy::Reject);
+	test_statistics<avo::concurrency::SpscMessageQueue>(OverflowPolicy::Reject);
+	test_statistics<avo::concurrency::MpmcMessageQueue>(OverflowPolicy::Reject);
+
+	auto [sender, receiver] = avo::concurrency::create_channel<int>(2, OverflowPolicy::DropOldest, nullptr, true);
+	REQUIRE(sender.send_batch(std::array{2, 4, 6}) == 3);
+	REQUIRE(receiver.drain() == std::vector{4, 6});
+	REQUIRE(receiver.statistics()->dropped_count == 1);
+	REQUIRE(receiver.statistics()->taken_count == 2);
+
+	auto [coalescing_sender, coalescing_receiver] = avo::concurrency::create_channel<int, avo::concurrency::SpscMessageQueue>(
+		4, OverflowPolicy::Coalesce, &add_if_both_even, true
+	);
+	REQUIRE(coalescing_sender.send_batch(std::array{2, 4, 6}) == 3);
+	REQUIRE(coalescing_sender.statistics()->coalesced_count == 2);
+	REQUIRE(coalescing_sender.statistics()->pushed_count == 1);
+
+	REQUIRE_FALSE(avo::concurrency::create_channel<int>().receiver.statistics());
+}
+
+TEST_CASE("Broadcast channel, every receiver gets every message") {
+	auto [sender, first_receiver] = avo::concurrency::create_broadcast_channel<int>(8);
+	auto second_receiver = first_receiver;
+
+	REQUIRE(sender.send_batch(messages) == messages.size());
+
+	auto third_receiver = sender.subscribe();
+	sender.send(3);
+
+	auto received = std::vector<int>{};
+	first_receiver.receive_all(std::back_inserter(received));
+	REQUIRE(std::ranges::equal(received, std::array{5, 184, 9, -4, 77, 1, 3}));
+
+	REQUIRE(second_receiver.lag() == 7);
+	REQUIRE(second_receiver.receive() == 5);
+	REQUIRE(third_receiver.receive() == 3);
+	REQUIRE_FALSE(third_receiver.try_receive());
+
+	// The second receiver falls behind by more than the capacity, which does not affect the others.
+	sender.send_batch(avo::util::Range{100, 104});
+	REQUIRE(first_receiver.receive() == 100);
+	REQUIRE(second_receiver.receive() == 77);
+	REQUIRE(second_receiver.missed_count() == 3);
+	REQUIRE(first_receiver.missed_count() == 0);
+}
+
+TEST_CASE("Broadcast channel, slow receivers between threads") {
+	static constexpr auto message_count = 20'000;
+
+	struct Message {
+		int value;
+		int negated;
+	};
+	auto [sender, receiver] = avo::concurrency::create_broadcast_channel<Message>(16);
+
+	auto results = std::array<std::pair<bool, std::size_t>, 3>{};
+	{
+		auto threads = std::vector<std::jthread>{};
+		for (auto& result : results) {
+			threads.emplace_back([receiver, &result]() mutable {
+				auto is_consistent = true;
+				auto received_count = std::size_t{};
+				for (auto previous = -1; previous != message_count - 1; ++received_count) {
+					auto const message = receiver.receive();
+					is_consistent = is_consistent && message.value > previous && message.negated == -message.value;
+					previous = message.value;
+				}
+				result = {is_consistent, received_count + receiver.missed_count()};
+			});
+		}
+		for (auto const i : avo::util::Range{message_count}) {
+			sender.send(Message{i, -i});
+		}
+	}
+	for (auto const& [is_consistent, total_count] : results) {
+		REQUIRE(is_consistent);
+		REQUIRE(total_count == message_count);
+	}
+}
+
+TEST_CASE("Timer wheel, expiring at the right tick") {
+	auto wheel = avo::concurrency::TimerWheel<avo::concurrency::TimerWheel<int>::Tick>{};
+
+	// Spread over all levels, including beyond the range of the top level.
+	auto expiries = std::vector<std::uint64_t>{};
+	for (auto const i : avo::util::Range{2'000}) {
+		expiries.push_back(static_cast<std::uint64_t>(i)*i*i*7 % 40'000'000 + 1);
+	}
+	auto ids = std::vector<avo::Id>{};
+	for (auto const expiry : expiries) {
+		ids.push_back(avo::Id::next());
+		wheel.add(ids.back(), expiry, expiry);
+	}
+	REQUIRE(wheel.size() == expiries.size());
+
+	auto cancelled_count = std::size_t{};
+	for (auto i = std::size_t{}; i < ids.size(); i += 3) {
+		cancelled_count += wheel.cancel(ids[i]);
+	}
+	REQUIRE(cancelled_count == (ids.size() + 2)/3);
+	REQUIRE_FALSE(wheel.cancel(ids[0]));
+
+	auto expired_count = std::size_t{};
+	auto is_on_time = true;
+	auto const expire = [&](avo::Id, std::uint64_t const expiry) {
+		is_on_time = is_on_time && expiry == wheel.current_tick();
+		++expired_count;
+	};
+	auto is_next_tick_ahead = true;
+	while (auto const next_tick = wheel.next_event_tick()) {
+		is_next_tick_ahead = is_next_tick_ahead && *next_tick > wheel.current_tick();
+		// Advancing in uneven steps must not matter.
+		wheel.advance(std::min(*next_tick, wheel.current_tick() + 1'000), expire);
+	}
+	REQUIRE(is_next_tick_ahead);
+	REQUIRE(is_on_time);
+	REQUIRE(expired_count == expiries.size() - cancelled_count);
+	REQUIRE(wheel.empty());
+
+	// A timer in the past expires on the next advance.
+	wheel.add(avo::Id::next(), 0, 0);
+	REQUIRE(wheel.advance(wheel.current_tick() + 1, [](avo::Id, std::uint64_t) {}) == 1);
+
+	// Adding a timer with the id of another one replaces it.
+	auto const id = avo::Id::next();
+	auto const start = wheel.current_tick();
+	wheel.add(id, start + 10, 10);
+	wheel.add(id, start + 5'000, 5'000);
+	REQUIRE(wheel.size() == 1);
+
+	auto expired_messages = std::vector<std::uint64_t>{};
+	auto const collect = [&](avo::Id, std::uint64_t const message) {
+		expired_messages.push_back(message);
+	};
+	wheel.advance(start + 100, collect);
+	REQUIRE(expired_messages.empty());
+	REQUIRE(wheel.contains(id));
+
+	wheel.add(id, start + 200, 200);
+	REQUIRE(wheel.size() == 1);
+	REQUIRE(wheel.cancel(id));
+	REQUIRE(wheel.empty());
+	wheel.advance(start + 10'000, collect);
+	REQUIRE(expired_messages.empty());
+}
+
+TEST_CASE("Timer scheduler, sending expired timers through a channel") {
+	using namespace std::chrono_literals;
+
+	auto [sender, receiver] = avo::concurrency::create_channel<int>();
+	auto scheduler = avo::concurrency::TimerScheduler{std::move(sender)};
+
+	auto const start = std::chrono::steady_clock::now();
+	scheduler.schedule_after(60ms, 3);
+	scheduler.schedule_after(20ms, 1);
+	auto const cancelled = scheduler.schedule_after(40ms, 2);
+	scheduler.schedule_after(40ms, 4);
+	REQUIRE(scheduler.pending_count() == 4);
+	REQUIRE(scheduler.cancel(cancelled));
+
+	REQUIRE(receiver.receive() == 1);
+	REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+	REQUIRE(receiver.receive() == 4);
+	REQUIRE(std::chrono::steady_clock::now() - start >= 40ms);
+	REQUIRE(receiver.receive() == 3);
+	REQUIRE(std::chrono::steady_clock::now() - start >= 60ms);
+	REQUIRE_FALSE(receiver.receive_for(20ms));
+	REQUIRE(scheduler.pending_count() == 0);
+}
+
+TEST_CASE("Timer scheduler, resending timers that a full channel rejected") {
+	using namespace std::chrono_literals;
+
+	auto [sender, receiver] = avo::concurrency::create_channel<int>(2);
+	auto scheduler = avo::concurrency::TimerScheduler{std::move(sender)};
+
+	auto const expiry = std::chrono::steady_clock::now() + 10ms;
+	for (auto const i : avo::util::Range{5}) {
+		scheduler.schedule_at(expiry, i);
+	}
+	std::this_thread::sleep_for(30ms);
+
+	auto received = std::vector<int>{};
+	while (auto const message = receiver.receive_for(500ms)) {
+		received.push_back(*message);
+		if (received.size() == 5) {
+			break;
+		}
+	}
+	// Timers that expire at the same tick are not sent in any particular order.
+	std::ranges::sort(received);
+	REQUIRE(received == std::vector{0, 1, 2, 3, 4});
+	REQUIRE(scheduler.pending_count() == 0);
+}
@@ -2,6 +2,12 @@
 
 #include <catch.hpp>
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
 TEST_CASE("avo::EventListeners test") {
 	auto result = 0.f;
 	
@@ -34,3 +40,293 @@ TEST_CASE("avo::EventListeners test") {
 	listeners(5.f);
 	REQUIRE(result == 15.f);
 }
+
+TEST_CASE("avo::InplaceEventListeners test") {
+	auto result = 0.f;
+	
+	auto listeners = avo::InplaceEventListeners<void(float), 2>{};
+
+	auto const first = [&](float const value) {
+		result += value;
+	};
+	listeners += first;
+	
+	auto const second = [&](float const value) {
+		result += value*0.5f;
+	};
+	listeners += second;
+
+	auto const third = [&](float const value) {
+		result -= value;
+	};
+	listeners += third;
+	REQUIRE(listeners.size() == 3);
+	
+	listeners(5.f);
+	REQUIRE(result == 2.5f);
+	
+	listeners -= third;
+	listeners -= first;
+	listeners(5.f);
+	REQUIRE(result == 5.f);
+	
+	listeners -= second;
+	REQUIRE(listeners.is_empty());
+	listeners(5.f);
+	REQUIRE(result == 5.f);
+
+	auto was_notifying = false;
+	listeners += [&](float) { was_notifying = listeners.is_notifying(); };
+	REQUIRE(not listeners.is_notifying());
+	listeners(5.f);
+	REQUIRE(was_notifying);
+	REQUIRE(not listeners.is_notifying());
+}
+
+namespace {
+
+struct Press {
+	int key;
+};
+struct Move {
+	float distance;
+};
+struct Close {};
+
+} // namespace
+
+TEST_CASE("avo::VariantEventListeners test") {
+	using Event = std::variant<Press, Move, Close>;
+	
+	auto listeners = avo::VariantEventListeners<Event>{};
+
+	static_assert(decltype(listeners)::is_listener<void(*)(Press const&)>);
+	static_assert(not decltype(listeners)::is_listener<void(*)(int)>);
+	static_assert(not decltype(listeners)::is_listener<decltype([](auto const&) {})>);
+
+	auto pressed_keys = 0;
+	auto distance = 0.f;
+	auto close_count = 0;
+
+	auto const count_keys = [&](Press const& event) { pressed_keys += event.key; };
+	listeners += count_keys;
+	listeners += [&](Press const& event) { pressed_keys += event.key*10; };
+	listeners += [&](Move const& event) { distance += event.distance; };
+	listeners.add(std::function{[&](Close const&) { ++close_count; }});
+	REQUIRE(listeners.listeners<Press>().size() == 2);
+	REQUIRE(listeners.listeners<Close>().size() == 1);
+
+	listeners(Press{2});
+	REQUIRE(pressed_keys == 22);
+	REQUIRE(distance == 0.f);
+
+	listeners(Move{1.5f});
+	listeners(Move{1.5f});
+	listeners(Close{});
+	REQUIRE(distance == 3.f);
+	REQUIRE(close_count == 1);
+	REQUIRE(pressed_keys == 22);
+
+	listeners.listeners<Press>() -= count_keys;
+	listeners(Press{1});
+	REQUIRE(pressed_keys == 32);
+}
+
+TEST_CASE("avo::EventListeners changed while notifying") {
+	auto listeners = avo::EventListeners<void(int)>{};
+
+	auto calls = std::vector<int>{};
+	
+	auto const added = [&](int const value) { calls.push_back(value*100); };
+	auto const removed = [&](int const value) { calls.push_back(value*10); };
+	auto const changing = [&](int const value) {
+		calls.push_back(value);
+		if (value == 1) {
+			listeners += added;
+			listeners -= removed;
+			REQUIRE(listeners.size() == 2);
+		}
+	};
+	listeners += changing;
+	listeners += removed;
+
+	// The added listener is not called and the removed one is skipped.
+	listeners(1);
+	REQUIRE(calls == std::vector{1});
+	REQUIRE(not listeners.is_notifying());
+	REQUIRE(listeners.size() == 2);
+
+	listeners(2);
+	REQUIRE(calls == std::vector{1, 2, 200});
+
+	// Removing a listener that was added during the same notification.
+	auto const adding_and_removing = [&](int) {
+		listeners += removed;
+		listeners -= removed;
+	};
+	listeners += adding_and_removing;
+	listeners(3);
+	REQUIRE(listeners.size() == 3);
+}
+
+TEST_CASE("avo::EventListeners listener removing itself") {
+	auto listeners = avo::EventListeners<void(int)>{};
+
+	auto received = std::vector<std::string>{};
+
+	auto handle = avo::ListenerHandle{};
+	handle = listeners.add([&, name = std::string(64, 'x')](int) {
+		listeners.remove(handle);
+		// The capture must still be alive after removing the listener.
+		received.push_back(name);
+	});
+	auto subscription = std::optional<avo::EventListeners<void(int)>::Subscription>{};
+	subscription = listeners.subscribe([&, name = std::string(64, 'y')](int) {
+		subscription.reset();
+		received.push_back(name);
+	});
+	auto const by_function = [&, name = std::string(64, 'z')](int) {
+		received.push_back(name);
+	};
+	listeners += [&, name = std::string(64, 'w')](int) {
+		listeners -= by_function;
+		received.push_back(name);
+	};
+	listeners += by_function;
+
+	listeners(1);
+	REQUIRE(received == std::vector{std::string(64, 'x'), std::string(64, 'y'), std::string(64, 'w')});
+	REQUIRE(listeners.size() == 1);
+
+	listeners(2);
+	REQUIRE(received.size() == 4);
+	REQUIRE(received.back() == std::string(64, 'w'));
+}
+
+TEST_CASE("avo::EventListeners listener throwing") {
+	auto listeners = avo::EventListeners<void(int)>{};
+
+	auto received = std::vector<int>{};
+
+	auto const throwing = listeners.add([&](int const value) {
+		listeners.add([&](int const value) { received.push_back(value); });
+		throw value;
+	});
+	REQUIRE_THROWS_AS(listeners(1), int);
+	REQUIRE_FALSE(listeners.is_notifying());
+	REQUIRE(listeners.size() == 2);
+
+	listeners.remove(throwing);
+	REQUIRE(listeners.size() == 1);
+	listeners(2);
+	REQUIRE(received == std::vector{2});
+}
+
+TEST_CASE("avo::EventListeners handles") {
+	auto listeners = avo::EventListeners<void(int)>{};
+
+	auto sum = 0;
+	auto const first = listeners.add([&](int const value) { sum += value; });
+	auto const second = listeners.add([&](int const value) { sum += value*10; });
+	auto const third = listeners.add([&](int const value) { sum += value*100; });
+	REQUIRE(first != second);
+	REQUIRE(listeners.contains(second));
+	REQUIRE(not listeners.contains(avo::ListenerHandle{}));
+
+	listeners(1);
+	REQUIRE(sum == 111);
+
+	REQUIRE(listeners.remove(first));
+	REQUIRE(not listeners.remove(first));
+	REQUIRE(not listeners.contains(first));
+	listeners(1);
+	REQUIRE(sum == 221);
+
+	// The slot of the removed listener is reused, but the old handle stays invalid.
+	auto const fourth = listeners.add([&](int const value) { sum += value*1000; });
+	REQUIRE(not listeners.contains(first));
+	REQUIRE(listeners.contains(fourth));
+	listeners -= third;
+	listeners(1);
+	REQUIRE(sum == 1231);
+
+	{
+		auto const subscription = listeners.subscribe([&](int const value) { sum -= value; });
+		REQUIRE(listeners.size() == 3);
+		listeners(1);
+		REQUIRE(sum == 2240);
+	}
+	REQUIRE(listeners.size() == 2);
+
+	// Removing by handle while notifying, including a listener that was added during the same notification.
+	auto added = avo::ListenerHandle{};
+	auto const removing = listeners.add([&](int) {
+		added = listeners.add([&](int) { sum = 0; });
+		listeners.remove(added);
+		listeners.remove(second);
+	});
+	listeners(1);
+	// The second listener was called before it was removed.
+	REQUIRE(sum == 3250);
+	REQUIRE(not listeners.contains(added));
+	REQUIRE(not listeners.contains(second));
+	REQUIRE(listeners.contains(removing));
+	REQUIRE(listeners.size() == 2);
+
+	listeners.remove(removing);
+	listeners(1);
+	REQUIRE(sum == 4250);
+}
+
+TEST_CASE("avo::EventQueue coalescing") {
+	auto queue = avo::EventQueue<void(int, std::string const&)>{};
+
+	auto received = std::vector<std::pair<int, std::string>>{};
+	queue.listeners() += [&](int const value, std::string const& name) {
+		received.emplace_back(value, name);
+		if (value == 1) {
+			queue.enqueue(1, "next frame");
+		}
+	};
+
+	REQUIRE(queue.enqueue(1, "invalidate"));
+	REQUIRE(not queue.enqueue(1, "invalidate"));
+	REQUIRE(queue.enqueue(2, "invalidate"));
+	REQUIRE(not queue.enqueue(1, "invalidate"));
+	REQUIRE(queue.pending_count() == 2);
+	REQUIRE(received.empty());
+
+	REQUIRE(queue.flush() == 2);
+	REQUIRE(received == std::vector<std::pair<int, std::string>>{{1, "invalidate"}, {2, "invalidate"}});
+	REQUIRE(queue.pending_count() == 1);
+
+	REQUIRE(queue.flush() == 1);
+	REQUIRE(received.back() == std::pair<int, std::string>{1, "next frame"});
+
+	queue.clear();
+	REQUIRE(queue.flush() == 0);
+}
+
+TEST_CASE("avo::EventQueue flushing from a listener") {
+	auto queue = avo::EventQueue<void(int)>{};
+
+	auto received = std::vector<int>{};
+	auto nested_flush_counts = std::vector<std::size_t>{};
+	queue.listeners() += [&](int const value) {
+		received.push_back(value);
+		REQUIRE(queue.is_flushing());
+		queue.enqueue(value + 10);
+		nested_flush_counts.push_back(queue.flush());
+	};
+
+	queue.enqueue(1);
+	queue.enqueue(2);
+	REQUIRE(queue.flush() == 2);
+	REQUIRE(received == std::vector{1, 2});
+	REQUIRE(nested_flush_counts == std::vector<std::size_t>{0, 0});
+	REQUIRE(not queue.is_flushing());
+	REQUIRE(queue.pending_count() == 2);
+
+	REQUIRE(queue.flush() == 2);
+	REQUIRE(received == std::vector{1, 2, 11, 12});
+}
@@ -1,7 +1,10 @@
 #include <avo/node.hpp>
+#include <avo/util/int_range.hpp>
 
 #include <catch.hpp>
 
+#include <thread>
+
 class SomeComponent {
 public:
 	int value() const {
@@ -64,6 +67,9 @@ TEST_CASE("Nodes with IDs") {
 	constexpr auto id_from_node = [](avo::Node const& node){ return node.id(); };
 	REQUIRE(std::ranges::equal(app.get_node(), std::array{avo::Id{1}, avo::Id{2}}, {}, id_from_node));
 	REQUIRE(std::ranges::equal(app.get_node() | avo::util::flatten, ids, {}, id_from_node));
+	REQUIRE(std::ranges::equal(avo::util::view_pre_order(app.get_node()), ids, {}, id_from_node));
+	REQUIRE(std::ranges::equal(avo::util::view_post_order(app.get_node()), 
+		std::array{avo::Id{3}, avo::Id{4}, avo::Id{1}, avo::Id{4}, avo::Id{5}, avo::Id{2}, avo::Id{}}, {}, id_from_node));
 
 	REQUIRE(app.get_node().find_by_id(avo::Id{4})->id() == avo::Id{4});
 	REQUIRE(std::ranges::distance(app.get_node().find_all_by_id(avo::Id{4})) == 2);
@@ -89,3 +95,253 @@ TEST_CASE("Nodes with IDs") {
 	REQUIRE(app.get_node()[1].component<SomeComponent>()->value() == 8);
 }
 
+
+TEST_CASE("Reparenting and destroying subtrees") {
+	constexpr auto node_count = 300;
+	constexpr auto id_count = 7;
+
+	auto root = avo::Node{};
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	for (auto const i : avo::util::Range{node_count}) {
+		// Mostly deep chains with some branching.
+		auto& parent = i < 3 ? root : *nodes[static_cast<std::size_t>(i - 1 - i % 3)];
+		nodes.push_back(std::make_unique<avo::Node>(parent, avo::Id{static_cast<avo::Id::value_type>(i % id_count + 1)}));
+	}
+
+	auto const is_index_consistent = [&] {
+		for (auto const& node : nodes) {
+			for (auto const id : avo::util::Range<avo::Id::value_type>{1, id_count}) {
+				auto const expected = std::ranges::count_if(*node | avo::util::flatten | std::views::drop(1), 
+					[id](avo::Node const& descendant) { return descendant.id() == avo::Id{id}; });
+				if (std::ranges::distance(node->find_all_by_id(avo::Id{id})) != expected) {
+					return false;
+				}
+				auto const found = node->find_by_id(avo::Id{id});
+				if ((found != nullptr) != (expected > 0) or (found and found->root() != node->root())) {
+					return false;
+				}
+			}
+			if (node->parent() && node->depth() != node->parent()->depth() + 1) {
+				return false;
+			}
+		}
+		return true;
+	};
+	REQUIRE(is_index_consistent());
+	REQUIRE(nodes.back()->depth() == 100);
+
+	// Move subtrees around, including into other subtrees.
+	for (auto const i : avo::util::Range<std::size_t>{1, 40}) {
+		auto& node = *nodes[i*7 % node_count];
+		auto& new_parent = *nodes[i*13 % node_count];
+		auto const is_ancestor = std::ranges::any_of(avo::util::view_parents(new_parent), 
+			[&](avo::Node* const ancestor) { return ancestor == &node; });
+		if (not is_ancestor) {
+			node.parent(new_parent);
+			REQUIRE(node.parent() == &new_parent);
+			REQUIRE(std::ranges::count(new_parent, &node, [](avo::Node const& child) { return &child; }) == 1);
+		}
+	}
+	REQUIRE(is_index_consistent());
+
+	for (auto i = std::size_t{}; i < nodes.size(); i += 5) {
+		nodes[i]->id(avo::Id{i % 3 + 1});
+	}
+	REQUIRE(is_index_consistent());
+
+	nodes[5]->detach();
+	REQUIRE(nodes[5]->depth() == 0);
+	REQUIRE(is_index_consistent());
+
+	auto const& later_sibling = *std::ranges::find_if(nodes, [](auto const& node) { return node->index_in_parent() > 0; });
+	later_sibling->detach();
+	REQUIRE(later_sibling->index_in_parent() == 0);
+	REQUIRE(is_index_consistent());
+
+	// Destroying a node detaches its children.
+	for (auto i = std::size_t{}; i < nodes.size(); i += 4) {
+		nodes[i].reset();
+	}
+	std::erase(nodes, nullptr);
+	REQUIRE(is_index_consistent());
+
+	// Const lookups do not write to the tree, so they can run on several threads after reparenting.
+	nodes[10]->parent(*nodes[20]);
+	auto lookup_counts = std::array<std::ptrdiff_t, 2>{};
+	{
+		auto threads = std::vector<std::jthread>{};
+		for (auto& count : lookup_counts) {
+			threads.emplace_back([&count, &node = std::as_const(*nodes[20])] {
+				for (auto const id : avo::util::Range<avo::Id::value_type>{1, id_count}) {
+					count += std::ranges::distance(node.find_all_by_id(avo::Id{id}));
+				}
+			});
+		}
+	}
+	REQUIRE(lookup_counts[0] == std::ranges::distance(*nodes[20] | avo::util::flatten) - 1);
+	REQUIRE(lookup_counts[1] == lookup_counts[0]);
+}
+
+TEST_CASE("Finding IDs that are repeated across the tree") {
+	constexpr auto row_count = 1'000;
+	auto const label_id = avo::Id{1};
+
+	// Every row of a list has a label with the same ID.
+	auto list = avo::Node{};
+	auto rows = std::vector<std::unique_ptr<avo::Node>>{};
+	auto labels = std::vector<std::unique_ptr<avo::Node>>{};
+	for (auto const i : avo::util::Range{row_count}) {
+		static_cast<void>(i);
+		auto& row = *rows.emplace_back(std::make_unique<avo::Node>(list, avo::Id{}));
+		labels.push_back(std::make_unique<avo::Node>(row, label_id));
+	}
+	REQUIRE(std::ranges::distance(list.find_all_by_id(label_id)) == row_count);
+
+	auto is_each_row_scoped = true;
+	for (auto const i : avo::util::Range<std::size_t>{row_count}) {
+		is_each_row_scoped = is_each_row_scoped 
+			and rows[i]->find_by_id(label_id) == labels[i].get()
+			and std::ranges::distance(rows[i]->find_all_by_id(label_id)) == 1;
+	}
+	REQUIRE(is_each_row_scoped);
+	REQUIRE(not labels[0]->find_by_id(label_id));
+
+	// Moving a label to another row within the tree keeps the lookups scoped.
+	labels[0]->parent(*rows[1]);
+	REQUIRE(not rows[0]->find_by_id(label_id));
+	REQUIRE(std::ranges::distance(rows[1]->find_all_by_id(label_id)) == 2);
+	REQUIRE(std::ranges::distance(list.find_all_by_id(label_id)) == row_count);
+}
+
+TEST_CASE("Components of nodes") {
+	auto app = App{};
+
+	auto values = std::vector<int>{};
+	avo::for_each_component<SomeComponent>(app.get_node(), [&](SomeComponent& component) {
+		values.push_back(component.value());
+	});
+	REQUIRE(values == std::vector{3, 10, 11, 8, 12, 13});
+
+	auto app_count = 0;
+	avo::for_each_component<App>(std::as_const(app).get_node(), [&](App const& component) {
+		REQUIRE(&component == &app);
+		++app_count;
+	});
+	REQUIRE(app_count == 1);
+
+	REQUIRE(app.get_node().component_type() == avo::util::TypeId::of<App>());
+	REQUIRE(app.get_node().component<App>() == &app);
+	REQUIRE(app.get_node().component<SomeComponent>() == nullptr);
+	REQUIRE(app.get_node()[0].component<App>() == nullptr);
+	REQUIRE(not avo::Node{}.component_type());
+
+	auto const value = 5;
+	auto const const_node = avo::Node{value};
+	REQUIRE(const_node.component<int const>() == &value);
+	REQUIRE(const_node.component<int>() == nullptr);
+}
+
+TEST_CASE("Dirty nodes") {
+	auto root = avo::Node{avo::Id{1}};
+	auto a = avo::Node{root, avo::Id{2}};
+	auto a0 = avo::Node{a, avo::Id{3}};
+	auto a1 = avo::Node{a, avo::Id{4}};
+	auto b = avo::Node{root, avo::Id{5}};
+	auto b0 = avo::Node{b, avo::Id{6}};
+
+	constexpr auto id_from_node = [](avo::Node const& node){ return node.id().value(); };
+
+	REQUIRE(std::ranges::empty(root.view_dirty_paths()));
+
+	a1.mark_dirty();
+	REQUIRE(a1.is_dirty());
+	REQUIRE(not a1.has_dirty_descendant());
+	REQUIRE(a.has_dirty_descendant());
+	REQUIRE(root.has_dirty_descendant());
+	REQUIRE(not b.has_dirty_descendant());
+	REQUIRE(std::ranges::equal(root.view_dirty_paths(), std::array{1u, 2u, 4u}, {}, id_from_node));
+
+	b.mark_dirty();
+	REQUIRE(std::ranges::equal(std::as_const(root).view_dirty_paths(), std::array{1u, 2u, 4u, 5u}, {}, id_from_node));
+	REQUIRE(std::ranges::equal(a.view_dirty_paths(), std::array{2u, 4u}, {}, id_from_node));
+	REQUIRE(std::ranges::empty(b0.view_dirty_paths()));
+
+	// Attaching a dirty subtree marks its new ancestors.
+	a.clear_dirty();
+	REQUIRE(not a1.is_dirty());
+	REQUIRE(not a.has_dirty_descendant());
+	a0.mark_dirty();
+	a0.detach();
+	REQUIRE(a.has_dirty_descendant());
+	a.clear_dirty();
+	a0.parent(b0);
+	REQUIRE(b0.has_dirty_descendant());
+	REQUIRE(std::ranges::equal(root.view_dirty_paths(), std::array{1u, 5u, 6u, 3u}, {}, id_from_node));
+
+	root.clear_dirty();
+	REQUIRE(std::ranges::empty(root.view_dirty_paths()));
+	REQUIRE(std::ranges::none_of(root | avo::util::flatten, [](avo::Node const& node) {
+		return node.is_dirty() or node.has_dirty_descendant();
+	}));
+}
+
+TEST_CASE("Adopting and detaching many nodes") {
+	auto root = avo::Node{};
+	auto other_root = avo::Node{};
+
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	for (auto const i : avo::util::Range<avo::Id::value_type>{1, 100}) {
+		nodes.push_back(std::make_unique<avo::Node>(avo::Id{i % 10}));
+		if (i > 50) {
+			// Give some of the nodes children of their own, and a parent to be moved from.
+			auto& child = *nodes.emplace_back(std::make_unique<avo::Node>(*nodes.back(), avo::Id{i % 10}));
+			child.mark_dirty();
+			nodes[nodes.size() - 2]->parent(other_root);
+		}
+	}
+	auto subtree_roots = std::vector<avo::Node*>{};
+	for (auto const& node : nodes) {
+		if (node->size() or not node->parent()) {
+			subtree_roots.push_back(node.get());
+		}
+	}
+
+	root.adopt(subtree_roots);
+	REQUIRE(root.size() == 100);
+	REQUIRE(other_root.size() == 0);
+	REQUIRE(std::ranges::distance(root | avo::util::flatten) == 151);
+	REQUIRE(std::ranges::distance(root.find_all_by_id(avo::Id{3})) == 15);
+	REQUIRE(root.has_dirty_descendant());
+	REQUIRE(root[99].depth() == 1);
+	REQUIRE(root[99][0].depth() == 2);
+	REQUIRE(std::ranges::equal(root, subtree_roots, {}, [](avo::Node& node) { return &node; }));
+
+	// Adopting nodes that are already children moves them to the end.
+	auto const first_children = std::array{&root[0], &root[1]};
+	root.adopt(first_children);
+	REQUIRE(root.size() == 100);
+	REQUIRE(&root[99] == first_children[1]);
+	REQUIRE(first_children[0]->parent() == &root);
+
+	root.detach_all();
+	REQUIRE(root.size() == 0);
+	REQUIRE(not root.find_by_id(avo::Id{3}));
+	REQUIRE(std::ranges::none_of(subtree_roots, [](auto const& node) { return node->parent(); }));
+	REQUIRE(nodes.back()->parent() == nodes[nodes.size() - 2].get());
+	REQUIRE(nodes.back()->depth() == 1);
+	REQUIRE(nodes[nodes.size() - 2]->find_by_id(nodes.back()->id()) == nodes.back().get());
+
+	// Destroying a node with children detaches them from the tree.
+	other_root.adopt(nodes | std::views::take(10));
+	auto parent = std::make_unique<avo::Node>(other_root, avo::Id{7});
+	nodes[10]->parent(*parent);
+	REQUIRE(parent->parent() == &other_root);
+	REQUIRE(other_root.size() == 11);
+	REQUIRE(nodes[10]->parent() == parent.get());
+	REQUIRE(std::ranges::count(other_root.find_all_by_id(nodes[10]->id()), nodes[10].get(), [](avo::Node& node) { return &node; }) == 1);
+	parent.reset();
+	REQUIRE(other_root.size() == 10);
+	REQUIRE(not nodes[10]->parent());
+	REQUIRE(std::ranges::count(other_root.find_all_by_id(nodes[10]->id()), nodes[10].get(), [](avo::Node& node) { return &node; }) == 0);
+	REQUIRE(std::ranges::distance(other_root | avo::util::flatten) == 11);
+}
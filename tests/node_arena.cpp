@@ -0,0 +1,75 @@
+#include <avo/node_arena.hpp>
+
+#include <catch.hpp>
+
+#include <algorithm>
+
+TEST_CASE("NodeArena trees") {
+	auto arena = avo::NodeArena{16};
+
+	auto component_values = std::array{3, 8, 10};
+
+	auto const root = arena.create();
+	auto const a = arena.create(root, avo::Id{1}, component_values[0]);
+	auto const b = arena.create(root, avo::Id{2}, component_values[1]);
+	auto const a0 = arena.create(a, avo::Id{3}, component_values[2]);
+	auto const a1 = arena.create(a, avo::Id{4});
+	auto const b0 = arena.create(b, avo::Id{4});
+
+	REQUIRE(arena.size() == 6);
+	REQUIRE(arena.parent(a0) == a);
+	REQUIRE(not arena.parent(root));
+	REQUIRE(arena.root(b0) == root);
+	REQUIRE(std::ranges::equal(arena.children(root), std::array{a, b}));
+	REQUIRE(std::ranges::equal(arena.subtree(root), std::array{root, a, a0, a1, b, b0}));
+	REQUIRE(std::ranges::equal(arena.subtree(a1), std::array{a1}));
+
+	REQUIRE(arena.find_by_id(root, avo::Id{4}) == a1);
+	REQUIRE(arena.find_by_id(b, avo::Id{4}) == b0);
+	REQUIRE(not arena.find_by_id(b, avo::Id{1}));
+	REQUIRE(std::ranges::distance(arena.find_all_by_id(root, avo::Id{4})) == 2);
+
+	REQUIRE(*arena.component<int>(a) == 3);
+	REQUIRE(arena.component<float>(a) == nullptr);
+	REQUIRE(arena.component<int>(a1) == nullptr);
+
+	auto sum = 0;
+	arena.for_each_component<int>(a, [&](int const value) { sum += value; });
+	REQUIRE(sum == 13);
+	sum = 0;
+	arena.for_each_component<int>([&](int const value) { sum += value; });
+	REQUIRE(sum == 21);
+
+	arena.parent(a, b);
+	REQUIRE(std::ranges::equal(arena.subtree(root), std::array{root, b, b0, a, a0, a1}));
+	arena.detach(b0);
+	REQUIRE(std::ranges::equal(arena.children(b), std::array{a}));
+	REQUIRE(not arena.parent(b0));
+
+	arena.destroy(a);
+	REQUIRE(arena.size() == 3);
+	REQUIRE(not arena.contains(a));
+	REQUIRE(not arena.contains(a0));
+	REQUIRE(arena.contains(b));
+	REQUIRE(std::ranges::empty(arena.children(b)));
+
+	sum = 0;
+	arena.for_each_component<int>([&](int const value) { sum += value; });
+	REQUIRE(sum == 8);
+
+	// Slots are reused, but handles to destroyed nodes stay invalid.
+	auto const c = arena.create(b, avo::Id{5});
+	REQUIRE(arena.contains(c));
+	REQUIRE(not arena.contains(a1));
+	REQUIRE(arena.find_by_id(root, avo::Id{5}) == c);
+
+	arena.clear();
+	REQUIRE(arena.empty());
+	REQUIRE(not arena.contains(root));
+	REQUIRE(not arena.contains(c));
+
+	auto const new_root = arena.create();
+	REQUIRE(arena.contains(new_root));
+	REQUIRE(new_root != root);
+	REQUIRE(std::ranges::equal(arena.subtree(new_root), std::array{new_root}));
+}
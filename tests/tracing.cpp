@@ -0,0 +1,113 @@
+#include <avo/tracing.hpp>
+#include <avo/window.hpp>
+
+#include <catch.hpp>
+
+#include <sstream>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("avo::tracing::Recorder Chrome trace output") {
+	auto recorder = avo::tracing::Recorder{};
+
+	auto const input_time = avo::tracing::Clock::now() - 5ms;
+	recorder.record(avo::tracing::Point::EventReceived, "KeyDown", input_time);
+	recorder.record(avo::tracing::Point::EventDispatched, "KeyDown", input_time);
+	recorder.record(avo::tracing::Point::EventDispatched, "FocusGain");
+	recorder.record(avo::tracing::Point::FramePresented, "Frame");
+	recorder.record(avo::tracing::Point::FramePresented, "Frame");
+
+	auto const records = recorder.records();
+	REQUIRE(records.size() == 5);
+	REQUIRE(records[1].source_time == input_time);
+	REQUIRE(not records[2].source_time);
+	REQUIRE(records[1].time >= records[0].time);
+
+	auto stream = std::ostringstream{};
+	recorder.write_chrome_trace(stream);
+	auto const trace = stream.str();
+
+	REQUIRE(trace.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+	REQUIRE(trace.ends_with("]}\n"));
+	REQUIRE(trace.find(R"({"name":"KeyDown","cat":"Event received")") != std::string::npos);
+	// Only the first frame has input waiting for it.
+	REQUIRE(trace.find(R"("name":"Input to present")") != std::string::npos);
+	REQUIRE(trace.find(R"("name":"Input to present")") == trace.rfind(R"("name":"Input to present")"));
+	// The oldest point is the input, which starts the trace.
+	REQUIRE(trace.find(R"("ph":"X","ts":0,)") != std::string::npos);
+
+	recorder.clear();
+	REQUIRE(recorder.records().empty());
+}
+
+TEST_CASE("avo::tracing::Recorder Chrome trace output of records seconds apart") {
+	auto recorder = avo::tracing::Recorder{};
+
+	auto const input_time = avo::tracing::Clock::time_point{} + 1000s;
+	recorder.add({
+		.point = avo::tracing::Point::EventDispatched, .name = "KeyDown", 
+		.time = input_time + 3s + 1500us, .source_time = input_time, .thread{}
+	});
+	recorder.add({
+		.point = avo::tracing::Point::FramePresented, .name = "Frame", 
+		.time = input_time + 3s + 2250us, .source_time{}, .thread{}
+	});
+	recorder.add({
+		.point = avo::tracing::Point::EventReceived, .name = "KeyUp", 
+		.time = input_time + 200s + 17us, .source_time = input_time + 200s, .thread{}
+	});
+
+	auto stream = std::ostringstream{};
+	recorder.write_chrome_trace(stream);
+	auto const trace = stream.str();
+
+	// Duration events of the dispatched key, the frame and the received key.
+	REQUIRE(trace.find(R"("ph":"X","ts":0,"dur":3001500})") != std::string::npos);
+	REQUIRE(trace.find(R"("ph":"X","ts":0,"dur":3002250})") != std::string::npos);
+	REQUIRE(trace.find(R"("ph":"X","ts":200000000,"dur":17})") != std::string::npos);
+	REQUIRE(trace.find(R"("ph":"i","s":"t","ts":3002250})") != std::string::npos);
+	REQUIRE(trace.find("e+") == std::string::npos);
+}
+
+TEST_CASE("avo::tracing hook") {
+	auto recorder = avo::tracing::Recorder{};
+
+	avo::tracing::record_frame_presented();
+	REQUIRE(avo::tracing::get_recorder() == nullptr);
+
+	avo::tracing::set_recorder(&recorder);
+
+	auto const timestamp = avo::tracing::Clock::now() - 1ms;
+	avo::window::trace_event(avo::tracing::Point::EventReceived, avo::window::event::MouseMove{.position{}, .movement{}, .timestamp = timestamp});
+	avo::window::trace_event(avo::tracing::Point::EventDispatched, avo::window::event::Closed{});
+	avo::tracing::record_frame_presented();
+
+	avo::tracing::set_recorder(nullptr);
+	avo::tracing::record_frame_presented();
+
+	auto const records = recorder.records();
+	REQUIRE(records.size() == 3);
+	REQUIRE(records[0].name == "MouseMove");
+	REQUIRE(records[0].source_time == timestamp);
+	REQUIRE(records[1].name == "Closed");
+	// Events without a timestamp have no source time.
+	REQUIRE(not records[1].source_time);
+	REQUIRE(records[2].point == avo::tracing::Point::FramePresented);
+}
+
+TEST_CASE("avo::window::merge_events keeps the oldest timestamp of mouse movements") {
+	auto const first_time = avo::tracing::Clock::now();
+
+	auto queued = avo::window::Event{avo::window::event::MouseMove{
+		.position{1.f, 1.f}, .movement{1.f, 0.f}, .timestamp = first_time
+	}};
+	REQUIRE(avo::window::merge_events(queued, avo::window::event::MouseMove{
+		.position{2.f, 3.f}, .movement{1.f, 2.f}, .timestamp = first_time + 1ms
+	}));
+
+	auto const& merged = std::get<avo::window::event::MouseMove>(queued);
+	REQUIRE(merged.position == avo::math::Point{2.f, 3.f});
+	REQUIRE(merged.movement == avo::math::Vector2d{2.f, 2.f});
+	REQUIRE(avo::window::get_timestamp(queued) == first_time);
+	REQUIRE(avo::window::get_event_name(queued) == "MouseMove");
+}
@@ -0,0 +1,58 @@
+#include <avo/util/inplace_function.hpp>
+
+#include <catch.hpp>
+
+#include <memory>
+
+namespace {
+
+int add_one(int const value) {
+	return value + 1;
+}
+
+} // namespace
+
+TEST_CASE("avo::util::InplaceFunction storing and calling callables") {
+	auto function = avo::util::InplaceFunction<int(int)>{};
+	REQUIRE(not function);
+
+	function = add_one;
+	REQUIRE(function);
+	REQUIRE(function(1) == 2);
+	REQUIRE(function.target_type() == avo::util::TypeId::of<int(*)(int)>());
+
+	auto offset = 10;
+	function = [&offset](int const value) { return value + offset; };
+	REQUIRE(function(1) == 11);
+	offset = 20;
+	REQUIRE(function(1) == 21);
+
+	auto const shared = std::make_shared<int>(5);
+	auto counting = avo::util::InplaceFunction<int(int)>{[shared](int const value) { return value + *shared; }};
+	REQUIRE(shared.use_count() == 2);
+	{
+		auto const copy = counting;
+		REQUIRE(shared.use_count() == 3);
+		REQUIRE(copy(1) == 6);
+	}
+	REQUIRE(shared.use_count() == 2);
+
+	auto moved = std::move(counting);
+	REQUIRE(not counting);
+	REQUIRE(shared.use_count() == 2);
+	REQUIRE(moved(2) == 7);
+
+	moved = {};
+	REQUIRE(shared.use_count() == 1);
+}
+
+TEST_CASE("avo::util::InplaceFunction comparing targets") {
+	using Function = avo::util::InplaceFunction<int(int), 16>;
+
+	auto const lambda = [](int const value) { return value*2; };
+	REQUIRE(Function{lambda}.has_same_target(Function{lambda}));
+	REQUIRE(not Function{lambda}.has_same_target(Function{add_one}));
+	REQUIRE(Function{add_one}.has_same_target(Function{add_one}));
+	REQUIRE(not Function{add_one}.has_same_target(Function{[](int const value) { return value; }}));
+	REQUIRE(Function{}.has_same_target(Function{}));
+}
@@ -177,3 +177,45 @@ TEST_CASE("avo::util::view_parents") {
 	++iterator;
 	REQUIRE(iterator == parent_range.end());
 }
+
+//------------------------------
+
+TEST_CASE("avo::util::view_pre_order and avo::util::view_post_order") {
+	auto [tree, expected_ids] = construct_test_with_parent_nodes();
+
+	REQUIRE(std::ranges::equal(avo::util::view_pre_order(*tree), expected_ids, {}, &TestNodeWithParent::id));
+	REQUIRE(std::ranges::equal(avo::util::view_post_order(*tree), 
+		std::vector{7, 8, 5, 6, 2, 3, 9, 10, 12, 11, 4, 1}, {}, &TestNodeWithParent::id));
+
+	// Traversing a subtree does not leave it.
+	auto& child_0 = tree->children[0];
+	REQUIRE(std::ranges::equal(avo::util::view_pre_order(child_0), std::vector{2, 5, 7, 8, 6}, {}, &TestNodeWithParent::id));
+	REQUIRE(std::ranges::equal(avo::util::view_post_order(child_0), std::vector{7, 8, 5, 6, 2}, {}, &TestNodeWithParent::id));
+	
+	auto& leaf = tree->children[1];
+	REQUIRE(std::ranges::equal(avo::util::view_pre_order(leaf), std::vector{3}, {}, &TestNodeWithParent::id));
+	REQUIRE(std::ranges::equal(avo::util::view_post_order(leaf), std::vector{3}, {}, &TestNodeWithParent::id));
+
+	for (auto& node : avo::util::view_pre_order(*tree)) {
+		node.id = 2;
+	}
+	REQUIRE(std::ranges::all_of(avo::util::view_post_order(*tree), [](int id){ return id == 2; }, &TestNodeWithParent::id));
+}
+
+TEST_CASE("avo::util::view_breadth_first") {
+	auto [tree, expected_ids] = construct_test_without_parent_nodes();
+
+	auto queue = std::vector<TestNode*>{};
+	REQUIRE(std::ranges::equal(avo::util::view_breadth_first(tree, queue), 
+		std::vector{1, 3, -5, -1, 2, 4, -3, -10}, {}, &TestNode::id));
+
+	// The queue is reused.
+	auto const capacity = queue.capacity();
+	REQUIRE(std::ranges::equal(avo::util::view_breadth_first(tree.children[1], queue), 
+		std::vector{-5, -3, -10}, {}, &TestNode::id));
+	REQUIRE(queue.capacity() == capacity);
+
+	auto const& const_tree = tree;
+	auto const_queue = std::vector<TestNode const*>{};
+	REQUIRE(std::ranges::distance(avo::util::view_breadth_first(const_tree, const_queue)) == 8);
+}
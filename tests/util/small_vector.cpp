@@ -0,0 +1,76 @@
+#include <avo/util/small_vector.hpp>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+
+TEST_CASE("avo::util::SmallVector growing beyond the inline capacity") {
+	auto vector = avo::util::SmallVector<std::string, 2>{};
+	REQUIRE(vector.empty());
+	REQUIRE(vector.capacity() == 2);
+
+	vector.push_back("first");
+	vector.emplace_back(3, 'a');
+	REQUIRE(vector.is_inline());
+	REQUIRE(vector.size() == 2);
+	REQUIRE(vector.back() == "aaa");
+
+	vector.push_back("a string that is too long for the small string optimization");
+	REQUIRE(not vector.is_inline());
+	REQUIRE(vector.size() == 3);
+	REQUIRE(vector.front() == "first");
+	REQUIRE(vector[1] == "aaa");
+
+	vector.pop_back();
+	REQUIRE(vector.size() == 2);
+	REQUIRE(std::ranges::equal(vector, std::array{"first", "aaa"}));
+}
+
+TEST_CASE("avo::util::SmallVector pushing one of its own elements when full") {
+	auto const long_string = std::string(64, 'x');
+
+	auto vector = avo::util::SmallVector<std::string, 2>{long_string, "b"};
+	vector.push_back(vector[0]);
+	REQUIRE(std::ranges::equal(vector, std::array{long_string, std::string{"b"}, long_string}));
+
+	vector.emplace_back(vector.back());
+	REQUIRE(vector.size() == 4);
+	REQUIRE(vector.capacity() == 4);
+	vector.emplace_back(vector.back());
+	REQUIRE(vector.size() == 5);
+	REQUIRE(vector.back() == long_string);
+}
+
+TEST_CASE("avo::util::SmallVector copying and moving") {
+	auto inline_vector = avo::util::SmallVector<std::unique_ptr<int>, 4>{};
+	inline_vector.push_back(std::make_unique<int>(1));
+	inline_vector.push_back(std::make_unique<int>(2));
+
+	auto moved_inline = std::move(inline_vector);
+	REQUIRE(moved_inline.is_inline());
+	REQUIRE(moved_inline.size() == 2);
+	REQUIRE(*moved_inline[1] == 2);
+
+	auto heap_vector = avo::util::SmallVector<std::unique_ptr<int>, 1>{};
+	heap_vector.push_back(std::make_unique<int>(3));
+	heap_vector.push_back(std::make_unique<int>(4));
+	auto const heap_data = heap_vector.data();
+
+	auto moved_heap = std::move(heap_vector);
+	REQUIRE(moved_heap.data() == heap_data);
+	REQUIRE(*moved_heap.back() == 4);
+
+	heap_vector = std::move(moved_heap);
+	REQUIRE(heap_vector.size() == 2);
+
+	auto const strings = avo::util::SmallVector<std::string, 2>{"a", "b", "c"};
+	auto copy = strings;
+	REQUIRE(std::ranges::equal(copy, strings));
+	copy = avo::util::SmallVector<std::string, 2>{"d"};
+	REQUIRE(copy.size() == 1);
+	copy = strings;
+	REQUIRE(copy.size() == 3);
+}
@@ -0,0 +1,21 @@
+#include <avo/util/type_id.hpp>
+
+#include <catch.hpp>
+
+#include <unordered_set>
+
+using avo::util::TypeId;
+
+static_assert(TypeId::of<int>() == TypeId::of<int>());
+static_assert(TypeId::of<int>() != TypeId::of<float>());
+static_assert(TypeId::of<int>() != TypeId::of<int const>());
+static_assert(TypeId::of<int>() != TypeId::of<int*>());
+static_assert(TypeId::of<int>());
+static_assert(not TypeId{});
+
+TEST_CASE("TypeId hashing") {
+	auto const ids = std::unordered_set{TypeId::of<int>(), TypeId::of<double>(), TypeId::of<int>(), TypeId{}};
+	REQUIRE(ids.size() == 3);
+	REQUIRE(ids.contains(TypeId::of<double>()));
+	REQUIRE(not ids.contains(TypeId::of<char>()));
+}